@@ -0,0 +1,162 @@
+#include "AppConfig.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+void add_symbol(std::vector<std::string>& out, std::string symbol) {
+    symbol.erase(std::remove_if(symbol.begin(), symbol.end(), ::isspace), symbol.end());
+    std::transform(symbol.begin(), symbol.end(), symbol.begin(), ::toupper);
+    if (symbol.empty()) return;
+    if (std::find(out.begin(), out.end(), symbol) == out.end()) out.push_back(symbol);
+}
+
+// 数値引数を読む。数字以外が混じるか範囲外ならメッセージを出して false
+template <typename T>
+bool parse_integer(const std::string& arg, const char* text, T& out) {
+    char* end = nullptr;
+    errno = 0;
+    long long value = std::strtoll(text, &end, 10);
+    bool in_range = value < 0
+        ? std::numeric_limits<T>::is_signed && value >= static_cast<long long>(std::numeric_limits<T>::min())
+        : static_cast<unsigned long long>(value) <= static_cast<unsigned long long>(std::numeric_limits<T>::max());
+    if (end == text || *end != '\0' || errno == ERANGE || !in_range) {
+        std::cerr << "Invalid number for " << arg << ": " << text << std::endl;
+        return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+}
+
+} // namespace
+
+bool parse_app_config(int argc, char* argv[], AppConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--conflate") {
+            config.conflate = true;
+        } else if (arg == "--train-warm-start") {
+            config.training.warm_start = true;
+            config.training.track_error = true;
+        } else if (arg == "--online-learning") {
+            config.online_learning = true;
+        } else if (arg == "--online-publish-sec" && has_value) {
+            int seconds = 0;
+            if (!parse_integer(arg, argv[++i], seconds)) return false;
+            if (seconds < 1) {
+                std::cerr << "--online-publish-sec must be positive" << std::endl;
+                return false;
+            }
+            config.online.publish_interval = std::chrono::seconds(seconds);
+        } else if (arg == "--relabel-sec" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.relabel_sec)) return false;
+            if (config.relabel_sec < 0) {
+                std::cerr << "--relabel-sec must not be negative" << std::endl;
+                return false;
+            }
+        } else if (arg == "--relabel-rows" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.relabel_rows)) return false;
+            if (config.relabel_rows < 1) {
+                std::cerr << "--relabel-rows must be positive" << std::endl;
+                return false;
+            }
+        } else if (arg == "--symbols" && has_value) {
+            config.symbols.clear();
+            std::stringstream ss(argv[++i]);
+            std::string symbol;
+            while (std::getline(ss, symbol, ',')) add_symbol(config.symbols, symbol);
+        } else if (arg == "--symbols-file" && has_value) {
+            std::ifstream file(argv[++i]);
+            if (!file.is_open()) {
+                std::cerr << "Cannot open symbols file: " << argv[i] << std::endl;
+                return false;
+            }
+            config.symbols.clear();
+            std::string symbol;
+            while (std::getline(file, symbol)) add_symbol(config.symbols, symbol);
+        } else if (arg == "--shards" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.shards)) return false;
+        } else if (arg == "--url" && has_value) {
+            config.stream_url = argv[++i];
+        } else if (arg == "--cpu" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.strategy_cpu)) return false;
+        } else if (arg == "--vol-window" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.windows.volatility_sec)) return false;
+        } else if (arg == "--corr-window" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.windows.correlation_sec)) return false;
+        } else if (arg == "--partition" && has_value) {
+            std::string period = argv[++i];
+            if (period == "hour") {
+                config.recorder.partition = PartitionPeriod::Hour;
+            } else if (period == "day") {
+                config.recorder.partition = PartitionPeriod::Day;
+            } else {
+                std::cerr << "--partition must be hour or day" << std::endl;
+                return false;
+            }
+        } else if (arg == "--retention-hours" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.recorder.retention_hours)) return false;
+        } else if (arg == "--som-search" && has_value) {
+            std::string mode = argv[++i];
+            if (mode == "full") {
+                config.som_search = SOMSearch::Full;
+            } else if (mode == "coherent") {
+                config.som_search = SOMSearch::Coherent;
+            } else {
+                std::cerr << "--som-search must be full or coherent" << std::endl;
+                return false;
+            }
+        } else if (arg == "--trainer" && has_value) {
+            std::string kind = argv[++i];
+            if (kind == "native") {
+                config.trainer = TrainerKind::Native;
+            } else if (kind == "python") {
+                config.trainer = TrainerKind::Python;
+            } else {
+                std::cerr << "--trainer must be native or python" << std::endl;
+                return false;
+            }
+        } else if (arg == "--train-mode" && has_value) {
+            std::string mode = argv[++i];
+            if (mode == "online") {
+                config.training.mode = SOMTrainingMode::Online;
+            } else if (mode == "batch") {
+                config.training.mode = SOMTrainingMode::Batch;
+            } else {
+                std::cerr << "--train-mode must be online or batch" << std::endl;
+                return false;
+            }
+        } else if (arg == "--train-rows" && has_value) {
+            if (!parse_integer(arg, argv[++i], config.training.train_rows)) return false;
+            if (config.training.train_rows < 1) {
+                std::cerr << "--train-rows must be positive" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    // 基準銘柄は常に購読する
+    add_symbol(config.symbols, config.btc_symbol);
+
+    if (config.windows.volatility_sec < 2 || config.windows.correlation_sec < 2) {
+        std::cerr << "Feature windows must be at least 2 seconds" << std::endl;
+        return false;
+    }
+
+    if (config.shards < 1) config.shards = 1;
+    if (config.shards > static_cast<int>(config.symbols.size())) {
+        config.shards = static_cast<int>(config.symbols.size());
+    }
+    return true;
+}
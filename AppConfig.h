@@ -0,0 +1,56 @@
+#ifndef APPCONFIG_H
+#define APPCONFIG_H
+
+#include "FeatureWindows.h"
+#include "RecorderOptions.h"
+#include "SOMOptions.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief コマンドライン引数で変えられる起動設定
+ */
+struct AppConfig {
+    std::vector<std::string> symbols = {"ATOMUSDT", "ETHUSDT", "SOLUSDT", "BTCUSDT"};
+    std::string btc_symbol = "BTCUSDT";                       // 全銘柄が参照する基準銘柄（必ず購読する）
+    std::string stream_url = "wss://stream.binance.com/stream"; // ポート9443を外し、/streamを明示
+    int shards = 1;          // WebSocket 接続数（銘柄を分担する）
+    int strategy_cpu = 1;    // 1本目のストラテジースレッドを固定するCPU（負ならピン留めしない）
+    bool conflate = false;   // 銘柄ごとに最新の板だけを処理する
+    FeatureWindows windows;  // 指標ごとの時間窓（秒）
+    RecorderOptions recorder; // 市場データの書き込み先・区切り・保持期間
+    SOMSearch som_search = SOMSearch::Full; // BMUの探し方
+    TrainerKind trainer = TrainerKind::Native; // SOMの学習をプロセス内で行うか、train_som.py を呼ぶか
+    SOMTrainingOptions training; // プロセス内で学習するときの設定
+    bool online_learning = false; // 再学習の合間もライブの特徴量でモデルを直す
+    OnlineLearningOptions online;
+    int relabel_sec = 0;          // 期待値とリスクだけを付け直す間隔（0 なら付け直さない）
+    size_t relabel_rows = 3600;   // 付け直しに使う最新の行数
+};
+
+/**
+ * @brief 引数を解釈する。不正な引数があればメッセージを出して false
+ *
+ *   --symbols A,B,C      購読する銘柄（カンマ区切り）
+ *   --symbols-file PATH  購読する銘柄（1行1銘柄）
+ *   --shards N           WebSocket 接続数
+ *   --url URL            結合ストリームのURL（ローカルのリプレイサーバーなど）
+ *   --cpu N              ストラテジースレッドの先頭CPU（-1でピン留めしない）
+ *   --conflate           間引きモード
+ *   --vol-window SEC     ボラティリティの窓（秒）
+ *   --corr-window SEC    BTC相関の窓（秒）
+ *   --partition hour|day 市場データファイルを区切る単位
+ *   --retention-hours N  これより古いパーティションを消す（0 なら消さない）
+ *   --som-search full|coherent  BMUを毎回全探索するか、前回のBMUの近傍から探すか（結果は同じ）
+ *   --trainer native|python     SOMの学習をプロセス内（SOMTrainer.h）で行うか、従来どおり train_som.py を呼ぶか
+ *   --train-mode online|batch   プロセス内の学習を1行ずつ行うか、バッチSOMで並列に行うか
+ *   --train-rows N              学習に使う最新の行数
+ *   --train-warm-start          公開中のモデルの重みから短いスケジュールで再学習する（エポックごとの量子化誤差も出す）
+ *   --online-learning           再学習の合間もライブの特徴量でモデルを少しずつ直す（SOMOnlineLearner.h）
+ *   --online-publish-sec N      オンライン学習で直したモデルを公開する間隔（秒）
+ *   --relabel-sec N             重みはそのままで、期待値とリスクだけを N 秒ごとに最新の行で付け直す
+ *   --relabel-rows N            付け直しに使う最新の行数
+ */
+bool parse_app_config(int argc, char* argv[], AppConfig& config);
+
+#endif
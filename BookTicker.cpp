@@ -0,0 +1,145 @@
+#include "BookTicker.h"
+#include <charconv>
+#include <system_error>
+
+namespace {
+
+// 走査中のフィールドの有無
+enum FieldBits : unsigned {
+    HAS_S = 1u << 0,
+    HAS_B = 1u << 1,
+    HAS_A = 1u << 2,
+    HAS_BV = 1u << 3,
+    HAS_AV = 1u << 4,
+    HAS_PRICES = HAS_B | HAS_A | HAS_BV | HAS_AV
+};
+
+struct Scanner {
+    const char* p;
+    const char* end;
+
+    void skip_ws() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    }
+
+    bool consume(char c) {
+        skip_ws();
+        if (p < end && *p == c) { ++p; return true; }
+        return false;
+    }
+
+    // 文字列を読み、引用符の内側をビューで返す（bookTickerのキー・値にエスケープは無いので扱わない）
+    bool read_string(std::string_view& out) {
+        skip_ws();
+        if (p >= end || *p != '"') return false;
+        const char* start = ++p;
+        while (p < end && *p != '"') {
+            if (*p == '\\') return false;
+            ++p;
+        }
+        if (p >= end) return false;
+        out = std::string_view(start, static_cast<size_t>(p - start));
+        ++p;
+        return true;
+    }
+
+    // 興味のない値（数値・null・入れ子）を読み飛ばす
+    bool skip_value() {
+        skip_ws();
+        if (p >= end) return false;
+        if (*p == '"') {
+            std::string_view dummy;
+            return read_string(dummy);
+        }
+        if (*p == '{' || *p == '[') {
+            int depth = 0;
+            while (p < end) {
+                char c = *p;
+                if (c == '"') {
+                    std::string_view dummy;
+                    if (!read_string(dummy)) return false;
+                    continue;
+                }
+                if (c == '{' || c == '[') ++depth;
+                else if (c == '}' || c == ']') {
+                    if (--depth == 0) { ++p; return true; }
+                }
+                ++p;
+            }
+            return false;
+        }
+        while (p < end && *p != ',' && *p != '}' && *p != ']') ++p;
+        return p < end;
+    }
+};
+
+bool parse_number(std::string_view text, double& out) {
+    if (text.empty()) return false;
+    const char* last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), last, out);
+    return ec == std::errc() && ptr == last;
+}
+
+// オブジェクトを1つ走査する。"data" が入れ子で来た場合はその中身も同じ出力に書き込む
+BookTickerError scan_object(Scanner& sc, BookTicker& out, unsigned& found, int depth) {
+    if (!sc.consume('{')) return BookTickerError::Malformed;
+    if (sc.consume('}')) return BookTickerError::Ok;
+
+    while (true) {
+        std::string_view key;
+        if (!sc.read_string(key) || !sc.consume(':')) return BookTickerError::Malformed;
+
+        sc.skip_ws();
+        if (key == "data" && depth == 0 && sc.p < sc.end && *sc.p == '{') {
+            BookTickerError err = scan_object(sc, out, found, depth + 1);
+            if (err != BookTickerError::Ok) return err;
+        } else if (key.size() == 1 && sc.p < sc.end && *sc.p == '"') {
+            std::string_view value;
+            if (!sc.read_string(value)) return BookTickerError::Malformed;
+            double* target = nullptr;
+            unsigned bit = 0;
+            switch (key[0]) {
+                case 's': out.symbol = value; found |= HAS_S; break;
+                case 'b': target = &out.bid_price; bit = HAS_B; break;
+                case 'a': target = &out.ask_price; bit = HAS_A; break;
+                case 'B': target = &out.bid_volume; bit = HAS_BV; break;
+                case 'A': target = &out.ask_volume; bit = HAS_AV; break;
+                default: break;
+            }
+            if (target) {
+                if (!parse_number(value, *target)) return BookTickerError::BadNumber;
+                found |= bit;
+            }
+        } else if (!sc.skip_value()) {
+            return BookTickerError::Malformed;
+        }
+
+        if (sc.consume(',')) continue;
+        if (sc.consume('}')) return BookTickerError::Ok;
+        return BookTickerError::Malformed;
+    }
+}
+
+} // namespace
+
+BookTickerError decode_book_ticker(std::string_view msg, BookTicker& out) {
+    Scanner sc{msg.data(), msg.data() + msg.size()};
+    unsigned found = 0;
+
+    BookTickerError err = scan_object(sc, out, found, 0);
+    if (err != BookTickerError::Ok) return err;
+    if (!(found & HAS_S)) return BookTickerError::NotTicker;
+    if ((found & HAS_PRICES) != HAS_PRICES) return BookTickerError::MissingField;
+    return BookTickerError::Ok;
+}
+
+const char* book_ticker_error_name(BookTickerError err) {
+    switch (err) {
+        case BookTickerError::Ok: return "Ok";
+        case BookTickerError::Malformed: return "Malformed";
+        case BookTickerError::NotTicker: return "NotTicker";
+        case BookTickerError::MissingField: return "MissingField";
+        case BookTickerError::BadNumber: return "BadNumber";
+    }
+    return "Unknown";
+}
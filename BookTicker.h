@@ -0,0 +1,38 @@
+#ifndef BOOKTICKER_H
+#define BOOKTICKER_H
+
+#include <string_view>
+
+/**
+ * @brief bookTicker のデコード結果
+ * symbol は入力バッファ（msg->str）を指すビューなので、バッファより長く保持しないこと
+ */
+struct BookTicker {
+    std::string_view symbol; // "s"
+    double bid_price = 0.0;  // "b"
+    double ask_price = 0.0;  // "a"
+    double bid_volume = 0.0; // "B"
+    double ask_volume = 0.0; // "A"
+};
+
+/**
+ * @brief デコード結果のエラーコード（例外は投げない）
+ */
+enum class BookTickerError {
+    Ok = 0,
+    Malformed,     // JSONとして壊れている
+    NotTicker,     // "s" が無い（購読応答など、bookTicker 以外のメッセージ）
+    MissingField,  // b/a/B/A のいずれかが無い
+    BadNumber      // 数値文字列を解釈できない
+};
+
+/**
+ * @brief Binance の bookTicker メッセージをその場で走査してデコードする
+ * 結合ストリーム形式 {"stream":…,"data":{…}} と、data 単体の形式の両方に対応。
+ * ヒープ確保は行わない。
+ */
+BookTickerError decode_book_ticker(std::string_view msg, BookTicker& out);
+
+const char* book_ticker_error_name(BookTickerError err);
+
+#endif
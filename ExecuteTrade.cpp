@@ -2,31 +2,37 @@
 #include "ScanMarket.h" // MarketStateを参照するために必要
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <iomanip>
 #include <chrono>
 
 static double total_pnl_pct = 0.0; // 通算損益（％）
 static int win_count = 0;
 static int loss_count = 0;
-std::map<std::string, std::chrono::steady_clock::time_point> last_exit_times;
+// 銘柄ごとの最終決済時刻（SymbolId で引く。未決済は time_point{}）
+static std::vector<std::chrono::steady_clock::time_point> last_exit_times;
+
+void init_trade_state(size_t symbol_count) {
+    last_exit_times.assign(symbol_count, std::chrono::steady_clock::time_point{});
+}
 
 bool is_market_crashing(const MarketState& state) {
     // BTCの相関が高く、かつBTCに対して負の方向への勢いが強い場合を「地合い悪化」とみなす
     // 強い相関があり、かつ「負の方向」への勢いが強いかチェック
     // state.diff がマイナス（下落方向）かつ ボラが高い場合
+    // btc_corr は1秒収益率のピアソン相関。0.7 は r² ≈ 0.5（値動きの半分をBTCで説明できる）の「強い相関」で、
+    // 無相関でも60個の収益率なら標準偏差は 1/√59 ≈ 0.13 なので、偶然 0.7 を超えることはまずない
     if (state.btc_corr > 0.7 && state.diff < -0.0005 && state.volatility > 0.001) {
         return true; 
     }
     return false;
 }
-void execute_trade(double expectancy, double current_price, std::string symbol, 
+void execute_trade(double expectancy, double current_price, SymbolId id, const SymbolRegistry& registry,
                    std::vector<TradeData>& pending_trades, double local_risk,
                    const MarketState& state) {
     // クールダウンチェック（決済から30秒間はエントリー禁止）
     auto now = std::chrono::steady_clock::now();
-    if (last_exit_times.count(symbol)) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_exit_times[symbol]).count();
+    if (last_exit_times[id] != std::chrono::steady_clock::time_point{}) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_exit_times[id]).count();
         if (elapsed < 30) return; // 30秒以内ならスキップ
     }
     
@@ -53,7 +59,7 @@ void execute_trade(double expectancy, double current_price, std::string symbol,
 
     // ボラティリティフィルター
     // 凪の状態でのインバランスは、価格が動かずタイムアップになりやすい
-    double vol_threshold = (symbol == "BTCUSDT") ? 0.00003 : 0.00008; // 銘柄ごとにボラの出やすさが違う
+    double vol_threshold = (id == registry.reference_id()) ? 0.00003 : 0.00008; // 銘柄ごとにボラの出やすさが違う
     if(state.volatility < vol_threshold) {
         // std::cout << symbol << " Skip: No Volatility (Vol: " << state.volatility << ")" << std::endl;
         return;
@@ -61,33 +67,36 @@ void execute_trade(double expectancy, double current_price, std::string symbol,
     
     // この銘柄でポジションが既にあるかチェック
     for (const auto& trade : pending_trades) {
-        if (trade.symbol == symbol) {
+        if (trade.symbol_id == id) {
             return;  // ポジション既存、スキップ
         }
     }
     
     // 新しいトレードを作成
     TradeData new_trade;
-    new_trade.symbol = symbol;
+    new_trade.symbol_id = id;
+    new_trade.symbol = registry.name(id);
     new_trade.entry_price = current_price;
     new_trade.entry_imbalance = local_risk;
     new_trade.entry_time = std::chrono::steady_clock::now();
     
     pending_trades.push_back(new_trade);
-    std::cout << "BUY " << symbol << " at " << current_price << std::endl;
+    std::cout << "BUY " << new_trade.symbol << " at " << current_price << std::endl;
 }
 
 void check_and_close_trades(std::vector<TradeData>& active_trades, 
-                            std::map<std::string, double>& current_prices) {
+                            const std::vector<double>& current_prices,
+                            const std::vector<std::int64_t>& price_recv_ns,
+                            LatencyHistogram* exit_latency) {
     auto now = std::chrono::steady_clock::now();
             
     for (auto it = active_trades.begin(); it != active_trades.end(); ) {
         // 現在の価格が取得できない場合はスキップ
-        if (current_prices.find(it->symbol) == current_prices.end()) {
+        double current_price = current_prices[it->symbol_id];
+        if (current_price <= 0.0) {
             ++it; continue;
         }
         
-        double current_price = current_prices[it->symbol];
         double pnl_ratio = (current_price - it->entry_price) / it->entry_price;
 
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->entry_time).count();
@@ -108,6 +117,10 @@ void check_and_close_trades(std::vector<TradeData>& active_trades,
         }
 
         if (should_close) {
+            if (exit_latency && price_recv_ns[it->symbol_id] > 0) {
+                exit_latency->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count() - price_recv_ns[it->symbol_id]);
+            }
             double pnl_pct = pnl_ratio * 100.0;
             total_pnl_pct += pnl_pct; // 合計に加算
             if (pnl_pct > 0) win_count++;
@@ -138,7 +151,7 @@ void check_and_close_trades(std::vector<TradeData>& active_trades,
                 all_file.close();
             }
 
-            last_exit_times[it->symbol] = std::chrono::steady_clock::now(); // 決済時刻を記録
+            last_exit_times[it->symbol_id] = std::chrono::steady_clock::now(); // 決済時刻を記録
             it = active_trades.erase(it); // ポジション削除
         } else {
             ++it;
@@ -6,7 +6,8 @@
 #include <string>
 #include <vector>
 #include <chrono>
-#include <map>
+#include "SymbolRegistry.h"
+#include "LatencyHistogram.h"
 
 struct MarketState; // 前方宣言
 // どこか別の場所で定義されている MarketState という構造体を使うよ
@@ -19,6 +20,7 @@ struct TradingConstraints {
 };
 
 struct TradeData {
+    SymbolId symbol_id = INVALID_SYMBOL;
     std::string symbol;
     std::string side;
     double entry_price;
@@ -31,10 +33,17 @@ struct TradeData {
     std::chrono::steady_clock::time_point entry_time;
 };
 
-void execute_trade(double expectancy, double current_price, std::string symbol, 
+// 銘柄ごとのクールダウン管理を銘柄数ぶん確保する（起動時に1回だけ呼ぶ）
+void init_trade_state(size_t symbol_count);
+
+void execute_trade(double expectancy, double current_price, SymbolId id, const SymbolRegistry& registry,
                    std::vector<TradeData>& pending_trades, double local_risk,
                    const MarketState& state);
+// current_prices は SymbolId で引く配列（未受信の銘柄は 0.0）
+// price_recv_ns はその価格の受信時刻。決済したら「価格受信 → SELL判定」の時間を exit_latency に記録する
 void check_and_close_trades(std::vector<TradeData>& active_trades, 
-                            std::map<std::string, double>& current_prices);
+                            const std::vector<double>& current_prices,
+                            const std::vector<std::int64_t>& price_recv_ns,
+                            LatencyHistogram* exit_latency);
 
 #endif
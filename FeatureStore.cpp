@@ -0,0 +1,250 @@
+#include "FeatureStore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+const std::array<const char*, FEATURE_COLUMN_COUNT> FEATURE_COLUMNS = {
+    "timestamp", "imbalance", "imbalance_change", "total_depth",
+    "price", "btc_price", "volatility", "btc_pearson"
+};
+
+namespace {
+
+const char MAGIC[8] = {'M', 'M', 'F', 'E', 'A', 'T', '\0', '\0'};
+constexpr std::streamoff ROW_COUNT_OFFSET = 32;
+constexpr std::streamoff SOURCE_STAMP_OFFSET = 4032;
+
+// ヘッダーはホストのバイト順のまま書く（x86/ARM のリトルエンディアン前提）
+template <typename T>
+void put(char* buf, size_t offset, T value) {
+    std::memcpy(buf + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const char* buf, size_t offset) {
+    T value;
+    std::memcpy(&value, buf + offset, sizeof(T));
+    return value;
+}
+
+std::streamoff column_offset(size_t column, std::uint64_t capacity) {
+    return static_cast<std::streamoff>(FEATURE_STORE_HEADER_SIZE + column * capacity * sizeof(double));
+}
+
+bool write_header(std::fstream& file, const std::string& symbol, std::uint64_t capacity, std::uint64_t row_count) {
+    std::vector<char> header(FEATURE_STORE_HEADER_SIZE, 0);
+    std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+    put<std::uint32_t>(header.data(), 8, FEATURE_STORE_VERSION);
+    put<std::uint32_t>(header.data(), 12, FEATURE_STORE_HEADER_SIZE);
+    put<std::uint32_t>(header.data(), 16, static_cast<std::uint32_t>(FEATURE_COLUMN_COUNT));
+    put<std::uint32_t>(header.data(), 20, FEATURE_STORE_DTYPE_F64);
+    put<std::uint64_t>(header.data(), 24, capacity);
+    put<std::uint64_t>(header.data(), 32, row_count);
+    std::memcpy(header.data() + 40, symbol.data(), std::min(symbol.size(), FEATURE_SYMBOL_SIZE - 1));
+    for (size_t c = 0; c < FEATURE_COLUMN_COUNT; ++c) {
+        std::strncpy(header.data() + 64 + c * FEATURE_NAME_SIZE, FEATURE_COLUMNS[c], FEATURE_NAME_SIZE - 1);
+    }
+    file.seekp(0);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    // 全列ぶんの領域を確保する（最後の1バイトを書いてファイル長を決める）
+    file.seekp(column_offset(FEATURE_COLUMN_COUNT, capacity) - 1);
+    file.put('\0');
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+bool FeatureStoreWriter::open(const std::string& path, const std::string& symbol, std::uint64_t capacity) {
+    close();
+    path_ = path;
+    symbol_ = symbol;
+    if (!std::filesystem::exists(path_)) return create(std::max<std::uint64_t>(capacity, 1));
+
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file_.is_open()) return false;
+
+    char header[64];
+    file_.read(header, sizeof(header));
+    if (!file_ || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+        get<std::uint32_t>(header, 8) != FEATURE_STORE_VERSION ||
+        get<std::uint32_t>(header, 12) != FEATURE_STORE_HEADER_SIZE ||
+        get<std::uint32_t>(header, 16) != FEATURE_COLUMN_COUNT ||
+        get<std::uint32_t>(header, 20) != FEATURE_STORE_DTYPE_F64) {
+        std::cerr << "Unsupported feature store format: " << path_ << std::endl;
+        file_.close();
+        return false;
+    }
+    capacity_ = get<std::uint64_t>(header, 24);
+    row_count_ = std::min(get<std::uint64_t>(header, 32), capacity_);
+    return true;
+}
+
+void FeatureStoreWriter::close() {
+    if (!file_.is_open()) return;
+    flush();
+    file_.close();
+}
+
+bool FeatureStoreWriter::create(std::uint64_t capacity) {
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) return false;
+    capacity_ = capacity;
+    row_count_ = 0;
+    if (!write_header(file_, symbol_, capacity_, 0)) return false;
+    file_.flush();
+    return true;
+}
+
+void FeatureStoreWriter::append(const FeatureRow& row) {
+    for (size_t c = 0; c < FEATURE_COLUMN_COUNT; ++c) pending_[c].push_back(row[c]);
+    ++pending_rows_;
+}
+
+// 列ごとに連続した領域へまとめて書き、最後に row_count を進める。
+// 途中で落ちても row_count より後ろは読まれないので、読む側が壊れた行を見ることはない
+bool FeatureStoreWriter::flush() {
+    if (pending_rows_ == 0 || !file_.is_open()) return true;
+    if (row_count_ + pending_rows_ > capacity_ && !grow(row_count_ + pending_rows_)) return false;
+
+    for (size_t c = 0; c < FEATURE_COLUMN_COUNT; ++c) {
+        file_.seekp(column_offset(c, capacity_) + static_cast<std::streamoff>(row_count_ * sizeof(double)));
+        file_.write(reinterpret_cast<const char*>(pending_[c].data()),
+                    static_cast<std::streamsize>(pending_[c].size() * sizeof(double)));
+        pending_[c].clear();
+    }
+    file_.flush();
+    row_count_ += pending_rows_;
+    pending_rows_ = 0;
+    return write_row_count();
+}
+
+bool FeatureStoreWriter::write_row_count() {
+    file_.seekp(ROW_COUNT_OFFSET);
+    file_.write(reinterpret_cast<const char*>(&row_count_), sizeof(row_count_));
+    file_.flush();
+    return static_cast<bool>(file_);
+}
+
+bool FeatureStoreWriter::write_source_stamp(const FeatureSourceStamp& stamp) {
+    if (!file_.is_open()) return false;
+    char buf[16];
+    put<std::uint64_t>(buf, 0, stamp.size);
+    put<std::int64_t>(buf, 8, stamp.mtime);
+    file_.seekp(SOURCE_STAMP_OFFSET);
+    file_.write(buf, sizeof(buf));
+    file_.flush();
+    return static_cast<bool>(file_);
+}
+
+// 容量を倍にした一時ファイルに列をコピーしてから置き換える
+bool FeatureStoreWriter::grow(std::uint64_t min_capacity) {
+    std::uint64_t new_capacity = std::max<std::uint64_t>(capacity_ * 2, min_capacity);
+    std::string tmp_path = path_ + ".tmp";
+    {
+        std::fstream tmp(tmp_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!tmp.is_open() || !write_header(tmp, symbol_, new_capacity, row_count_)) return false;
+        std::vector<double> column(row_count_);
+        for (size_t c = 0; c < FEATURE_COLUMN_COUNT; ++c) {
+            file_.seekg(column_offset(c, capacity_));
+            file_.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(double)));
+            tmp.seekp(column_offset(c, new_capacity));
+            tmp.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(double)));
+        }
+        if (!file_ || !tmp) return false;
+    }
+    file_.close();
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path_, ec);
+    if (ec) {
+        std::cerr << "Failed to replace " << path_ << ": " << ec.message() << std::endl;
+        file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
+        return false;
+    }
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
+    capacity_ = new_capacity;
+    return file_.is_open();
+}
+
+// --- FeatureStoreReader ---
+
+bool FeatureStoreReader::open(const std::string& path) {
+    file_.close();
+    file_.clear();
+    file_.open(path, std::ios::binary);
+    if (!file_.is_open()) return false;
+
+    char header[64];
+    file_.read(header, sizeof(header));
+    if (!file_ || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+        get<std::uint32_t>(header, 8) != FEATURE_STORE_VERSION ||
+        get<std::uint32_t>(header, 12) != FEATURE_STORE_HEADER_SIZE ||
+        get<std::uint32_t>(header, 16) != FEATURE_COLUMN_COUNT ||
+        get<std::uint32_t>(header, 20) != FEATURE_STORE_DTYPE_F64) {
+        file_.close();
+        return false;
+    }
+    capacity_ = get<std::uint64_t>(header, 24);
+    row_count_ = std::min(get<std::uint64_t>(header, 32), capacity_);
+
+    char stamp[16];
+    file_.seekg(SOURCE_STAMP_OFFSET);
+    file_.read(stamp, sizeof(stamp));
+    if (!file_) {
+        file_.close();
+        return false;
+    }
+    source_stamp_.size = get<std::uint64_t>(stamp, 0);
+    source_stamp_.mtime = get<std::int64_t>(stamp, 8);
+    return true;
+}
+
+bool FeatureStoreReader::read(std::uint64_t start, std::uint64_t stop, std::vector<FeatureRow>& out) {
+    stop = std::min(stop, row_count_);
+    if (!file_.is_open() || start >= stop) return file_.is_open();
+
+    size_t base = out.size();
+    size_t n = static_cast<size_t>(stop - start);
+    out.resize(base + n);
+    std::vector<double> column(n);
+    for (size_t c = 0; c < FEATURE_COLUMN_COUNT; ++c) {
+        file_.seekg(column_offset(c, capacity_) + static_cast<std::streamoff>(start * sizeof(double)));
+        file_.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(n * sizeof(double)));
+        for (size_t i = 0; i < n; ++i) out[base + i][c] = column[i];
+    }
+    if (!file_) {
+        out.resize(base);
+        file_.clear();
+        return false;
+    }
+    return true;
+}
+
+double FeatureStoreReader::timestamp_at(std::uint64_t row) {
+    double ts = 0.0;
+    file_.seekg(column_offset(0, capacity_) + static_cast<std::streamoff>(row * sizeof(double)));
+    file_.read(reinterpret_cast<char*>(&ts), sizeof(ts));
+    return ts;
+}
+
+std::uint64_t FeatureStoreReader::lower_bound(double ts) {
+    std::uint64_t lo = 0, hi = row_count_;
+    while (lo < hi) {
+        std::uint64_t mid = lo + (hi - lo) / 2;
+        if (timestamp_at(mid) < ts) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+std::uint64_t FeatureStoreReader::upper_bound(double ts) {
+    std::uint64_t lo = 0, hi = row_count_;
+    while (lo < hi) {
+        std::uint64_t mid = lo + (hi - lo) / 2;
+        if (timestamp_at(mid) <= ts) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
@@ -0,0 +1,118 @@
+#ifndef FEATURESTORE_H
+#define FEATURESTORE_H
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * 銘柄ごとの特徴量ファイル（data/SYMBOL_features.bin）の形式
+ *
+ *   [ヘッダー 4096 バイト]
+ *     0  char[8]   magic "MMFEAT\0\0"
+ *     8  uint32    version
+ *    12  uint32    header_size（4096）
+ *    16  uint32    column_count
+ *    20  uint32    dtype（1 = float64）
+ *    24  uint64    capacity（1列あたりの行数の上限）
+ *    32  uint64    row_count（書き終わった行数。列を書いてから更新する）
+ *    40  char[24]  symbol
+ *    64  char[32] × column_count  列名
+ *  4032  uint64    source_size（区切る前の CSV から写したときの、元の CSV の大きさ。写していなければ 0）
+ *  4040  int64     source_mtime（同じく元の CSV の更新時刻。同じかどうかを比べるだけの値）
+ *   [列 0: float64 × capacity][列 1: float64 × capacity] ...
+ *
+ * すべてリトルエンディアン。列 i は header_size + i * capacity * 8 から始まるので、
+ * 読む側は numpy.memmap でそのまま配列として開ける（feature_store.py）。
+ */
+constexpr std::uint32_t FEATURE_STORE_VERSION = 1;
+constexpr std::uint32_t FEATURE_STORE_HEADER_SIZE = 4096;
+constexpr std::uint32_t FEATURE_STORE_DTYPE_F64 = 1;
+constexpr size_t FEATURE_COLUMN_COUNT = 8;
+constexpr size_t FEATURE_NAME_SIZE = 32;
+constexpr size_t FEATURE_SYMBOL_SIZE = 24;
+
+// 列の並び（CSVの symbol 以外の列と同じ順）
+extern const std::array<const char*, FEATURE_COLUMN_COUNT> FEATURE_COLUMNS;
+
+using FeatureRow = std::array<double, FEATURE_COLUMN_COUNT>;
+
+// 特徴量ファイルの元にした CSV（backfill_legacy_features）
+struct FeatureSourceStamp {
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+
+    bool operator==(const FeatureSourceStamp& o) const { return size == o.size && mtime == o.mtime; }
+    bool operator!=(const FeatureSourceStamp& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief 特徴量ファイルへの追記（書き手1スレッド）
+ * append() はメモリ上の列バッファに積むだけで、flush() で列ごとにまとめて書いてから row_count を更新する。
+ * capacity を超えるときは倍の容量のファイルを作り直して置き換える（まれなので償却で十分）。
+ */
+class FeatureStoreWriter {
+public:
+    static constexpr std::uint64_t DEFAULT_CAPACITY = 1u << 18; // 1秒1行で約3日分（1銘柄16MB）
+
+    FeatureStoreWriter() = default;
+    ~FeatureStoreWriter() { close(); }
+    FeatureStoreWriter(const FeatureStoreWriter&) = delete;
+    FeatureStoreWriter& operator=(const FeatureStoreWriter&) = delete;
+
+    // 既存のファイルがあれば続きから書く（形式が違えば false）
+    bool open(const std::string& path, const std::string& symbol, std::uint64_t capacity = DEFAULT_CAPACITY);
+    void close();
+    bool is_open() const { return file_.is_open(); }
+
+    void append(const FeatureRow& row);
+    bool flush();
+    bool write_source_stamp(const FeatureSourceStamp& stamp);
+
+    // 書き終わった行数 + バッファ中の行数
+    std::uint64_t row_count() const { return row_count_ + pending_rows_; }
+    std::uint64_t capacity() const { return capacity_; }
+
+private:
+    bool create(std::uint64_t capacity);
+    bool grow(std::uint64_t min_capacity);
+    bool write_row_count();
+
+    std::string path_;
+    std::string symbol_;
+    std::fstream file_;
+    std::uint64_t capacity_ = 0;
+    std::uint64_t row_count_ = 0;
+    std::array<std::vector<double>, FEATURE_COLUMN_COUNT> pending_; // 列ごとの未書き込み分
+    std::uint64_t pending_rows_ = 0;
+};
+
+/**
+ * @brief 特徴量ファイルの読み込み（必要な行の範囲だけを読む）
+ * 書き込み中のファイルでもよい（ヘッダーの row_count までを読む）
+ */
+class FeatureStoreReader {
+public:
+    bool open(const std::string& path);
+    std::uint64_t row_count() const { return row_count_; }
+    const FeatureSourceStamp& source_stamp() const { return source_stamp_; }
+
+    // 行 [start, stop) を out の末尾に追加する
+    bool read(std::uint64_t start, std::uint64_t stop, std::vector<FeatureRow>& out);
+    // timestamp >= ts となる最初の行（timestamp は書き込み順に単調増加）。無ければ row_count()
+    std::uint64_t lower_bound(double ts);
+    // timestamp > ts となる最初の行
+    std::uint64_t upper_bound(double ts);
+
+private:
+    double timestamp_at(std::uint64_t row);
+
+    std::ifstream file_;
+    std::uint64_t capacity_ = 0;
+    std::uint64_t row_count_ = 0;
+    FeatureSourceStamp source_stamp_;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef FEATUREWINDOWS_H
+#define FEATUREWINDOWS_H
+
+// 指標ごとの窓の長さ（秒）。価格は1秒ごとのバケットにまとめてから計算する
+struct FeatureWindows {
+    int volatility_sec = 60;
+    int correlation_sec = 60;
+};
+
+#endif
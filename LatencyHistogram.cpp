@@ -0,0 +1,101 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// 0〜31 ns はそのまま、それ以上は (2の冪の指数, 上位5ビット) でバケットを決める
+int LatencyHistogram::bucket_of(std::uint64_t ns) {
+    if (ns < static_cast<std::uint64_t>(SUB_COUNT)) return static_cast<int>(ns);
+    int exp = 63;
+    while (!(ns >> exp)) --exp; // 最上位ビットの位置
+    int sub = static_cast<int>((ns >> (exp - SUB_BITS)) & (SUB_COUNT - 1));
+    return (exp - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+namespace {
+
+// バケットの代表値（下端）
+std::int64_t bucket_value(int bucket) {
+    const int sub_count = LatencyHistogram::SUB_COUNT;
+    if (bucket < sub_count) return bucket;
+    int exp = bucket / sub_count + LatencyHistogram::SUB_BITS - 1;
+    std::uint64_t sub = static_cast<std::uint64_t>(bucket % sub_count);
+    return static_cast<std::int64_t>((std::uint64_t(sub_count) + sub) << (exp - LatencyHistogram::SUB_BITS));
+}
+
+} // namespace
+
+void LatencyHistogram::record(std::int64_t ns) {
+    if (ns < 0) ns = 0;
+    // 書き手は1スレッドなので read-modify-write をアトミック命令にしない
+    auto& c = counts_[bucket_of(static_cast<std::uint64_t>(ns))];
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ns > max_ns_.load(std::memory_order_relaxed)) max_ns_.store(ns, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot s;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        s.count += s.counts[i];
+    }
+    s.max_ns = max_ns_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    for (int i = 0; i < BUCKET_COUNT; ++i) counts[i] += other.counts[i];
+    count += other.count;
+    if (other.max_ns > max_ns) max_ns = other.max_ns;
+}
+
+std::int64_t LatencyHistogram::Snapshot::percentile(double q) const {
+    if (count == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(count));
+    if (rank >= count) rank = count - 1;
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts[i];
+        if (seen > rank) return std::min(bucket_value(i), max_ns);
+    }
+    return max_ns;
+}
+
+void print_latency_report(const std::vector<LatencyReportRow>& rows) {
+    std::cout << "========== LATENCY (us) ==========" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& row : rows) {
+        const auto& s = row.snapshot;
+        std::cout << " " << std::left << std::setw(10) << row.stage << std::right
+                  << " n=" << s.count
+                  << " p50=" << s.percentile(0.50) / 1000.0
+                  << " p99=" << s.percentile(0.99) / 1000.0
+                  << " p99.9=" << s.percentile(0.999) / 1000.0
+                  << " max=" << s.max_ns / 1000.0 << std::endl;
+    }
+    std::cout << "==================================" << std::endl;
+}
+
+void append_latency_csv(const std::string& filename, const std::vector<LatencyReportRow>& rows) {
+    bool file_exists = std::filesystem::exists(filename);
+    std::ofstream file(filename, std::ios::app);
+    if (!file.is_open()) return;
+    if (!file_exists) {
+        file << "timestamp,stage,count,p50_us,p99_us,p999_us,max_us\n";
+    }
+    long long ts = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    file << std::fixed << std::setprecision(3);
+    for (const auto& row : rows) {
+        const auto& s = row.snapshot;
+        file << ts << "," << row.stage << "," << s.count << ","
+             << s.percentile(0.50) / 1000.0 << ","
+             << s.percentile(0.99) / 1000.0 << ","
+             << s.percentile(0.999) / 1000.0 << ","
+             << s.max_ns / 1000.0 << "\n";
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief HDR風の対数-線形バケットのレイテンシ・ヒストグラム（ns単位）
+ * 2の冪ごとに32分割するので相対誤差は約3%。record() は書き手1スレッド前提で、
+ * ロックも確保もしない。snapshot() は他スレッドから呼んでよい（多少古い値でよい用途）。
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;         // 2の冪ごとの分割数
+    static constexpr int BUCKET_COUNT = (64 - SUB_BITS) * SUB_COUNT;
+
+    struct Snapshot {
+        std::vector<std::uint64_t> counts = std::vector<std::uint64_t>(BUCKET_COUNT, 0);
+        std::uint64_t count = 0;
+        std::int64_t max_ns = 0;
+
+        void merge(const Snapshot& other);
+        // q は 0.0〜1.0（0.99 なら p99）
+        std::int64_t percentile(double q) const;
+    };
+
+    void record(std::int64_t ns);
+    Snapshot snapshot() const;
+
+private:
+    static int bucket_of(std::uint64_t ns);
+
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> counts_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::int64_t> max_ns_{0};
+
+};
+
+/**
+ * @brief 1ティックの各段階の所要時間（シャードごとに1組、書き手はそのストラテジースレッド）
+ *   parse   : 受信 → デコード完了（Queue モードではリング待ちを含む）
+ *   process : デコード完了 → process_ws_data 完了
+ *   predict : process_ws_data 完了 → getPrediction 完了
+ *   execute : getPrediction 完了 → execute_trade 完了
+ *   total   : 受信 → execute_trade 完了（発注判定まで進んだティックのみ）
+ */
+struct TickLatency {
+    LatencyHistogram parse;
+    LatencyHistogram process;
+    LatencyHistogram predict;
+    LatencyHistogram execute;
+    LatencyHistogram total;
+};
+
+struct LatencyReportRow {
+    std::string stage;
+    LatencyHistogram::Snapshot snapshot;
+};
+
+// p50/p99/p99.9/max（µs）を表形式でコンソールに出す
+void print_latency_report(const std::vector<LatencyReportRow>& rows);
+// 同じ内容を CSV に追記する（timestamp,stage,count,p50_us,p99_us,p999_us,max_us）
+void append_latency_csv(const std::string& filename, const std::vector<LatencyReportRow>& rows);
+
+#endif
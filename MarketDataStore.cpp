@@ -0,0 +1,302 @@
+#include "MarketDataStore.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr std::uint64_t BACKFILL_BATCH_ROWS = 1u << 16;
+
+// 1970-01-01 からの日数 → 年月日（H. Hinnant の civil_from_days）
+void civil_from_days(std::int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    std::int64_t year = static_cast<std::int64_t>(yoe) + era * 400;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(year + (m <= 2));
+}
+
+bool parse_i64(std::string_view s, std::int64_t& out) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc();
+}
+
+bool parse_u64(std::string_view s, std::uint64_t& out) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc();
+}
+
+// 区切る前の1ファイル形式（最も古いパーティションとして読む）
+std::string legacy_features_path(const std::string& data_dir, const std::string& symbol) {
+    return data_dir + "/" + symbol + "_features.bin";
+}
+
+std::string legacy_csv_path(const std::string& data_dir, const std::string& symbol) {
+    return data_dir + "/" + symbol + "_market_data.csv";
+}
+
+// CSV の大きさと更新時刻（同じかどうかを比べるだけなので、時刻はファイル時計の刻みのまま）
+bool csv_source_stamp(const std::string& path, FeatureSourceStamp& out) {
+    std::error_code ec;
+    std::uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    out.size = size;
+    out.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+// CSV の1行（timestamp,symbol,数値7個）。ヘッダーや壊れた行は false
+bool parse_csv_row(std::string_view line, FeatureRow& row) {
+    size_t col = 0, field = 0;
+    while (field < 9) {
+        size_t comma = line.find(',');
+        std::string_view value = line.substr(0, comma);
+        if (field != 1) {
+            while (!value.empty() && (value.back() == '\r' || value.back() == ' ')) value.remove_suffix(1);
+            auto r = std::from_chars(value.data(), value.data() + value.size(), row[col++]);
+            if (r.ec != std::errc() || r.ptr != value.data() + value.size()) return false;
+        }
+        ++field;
+        if (comma == std::string_view::npos) break;
+        line.remove_prefix(comma + 1);
+    }
+    return field == 9;
+}
+
+// 読む対象のファイルを古い順に
+std::vector<std::string> feature_files(const std::string& data_dir, const std::string& symbol,
+                                       const std::vector<PartitionInfo>& partitions) {
+    std::vector<std::string> files;
+    std::string legacy = legacy_features_path(data_dir, symbol);
+    if (std::filesystem::exists(legacy)) files.push_back(legacy);
+    for (const auto& p : partitions) files.push_back(partition_features_path(data_dir, symbol, p.name));
+    return files;
+}
+
+} // namespace
+
+std::int64_t partition_seconds(PartitionPeriod period) {
+    return period == PartitionPeriod::Hour ? 3600 : 86400;
+}
+
+std::string partition_name(std::int64_t ts, PartitionPeriod period) {
+    std::int64_t days = ts >= 0 ? ts / 86400 : (ts - 86399) / 86400;
+    int y;
+    unsigned m, d;
+    civil_from_days(days, y, m, d);
+    // 年は int、月日時は unsigned の全範囲でも切れない大きさ（実際は10桁）
+    char buf[48];
+    if (period == PartitionPeriod::Hour) {
+        unsigned hour = static_cast<unsigned>((ts - days * 86400) / 3600);
+        std::snprintf(buf, sizeof(buf), "%04d%02u%02u%02u", y, m, d, hour);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%04d%02u%02u", y, m, d);
+    }
+    return buf;
+}
+
+std::string symbol_data_dir(const std::string& data_dir, const std::string& symbol) {
+    return data_dir + "/" + symbol;
+}
+
+std::string partition_csv_path(const std::string& data_dir, const std::string& symbol, const std::string& name) {
+    return symbol_data_dir(data_dir, symbol) + "/" + name + "_market_data.csv";
+}
+
+std::string partition_features_path(const std::string& data_dir, const std::string& symbol, const std::string& name) {
+    return symbol_data_dir(data_dir, symbol) + "/" + name + "_features.bin";
+}
+
+bool load_manifest(const std::string& data_dir, const std::string& symbol, std::vector<PartitionInfo>& out) {
+    out.clear();
+    std::ifstream file(symbol_data_dir(data_dir, symbol) + "/manifest.csv");
+    if (!file.is_open()) return true;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        // partition,first_ts,last_ts,rows
+        std::string_view rest(line);
+        std::string_view cols[4];
+        size_t n = 0;
+        while (n < 4) {
+            size_t comma = rest.find(',');
+            cols[n++] = rest.substr(0, comma);
+            if (comma == std::string_view::npos) break;
+            rest.remove_prefix(comma + 1);
+        }
+        PartitionInfo p;
+        if (n < 4 || !parse_i64(cols[1], p.first_ts) || !parse_i64(cols[2], p.last_ts) || !parse_u64(cols[3], p.rows)) {
+            continue; // ヘッダーや壊れた行
+        }
+        p.name.assign(cols[0]);
+        out.push_back(std::move(p));
+    }
+    std::sort(out.begin(), out.end(), [](const PartitionInfo& a, const PartitionInfo& b) { return a.name < b.name; });
+    return true;
+}
+
+bool save_manifest(const std::string& data_dir, const std::string& symbol, const std::vector<PartitionInfo>& partitions) {
+    std::string path = symbol_data_dir(data_dir, symbol) + "/manifest.csv";
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << "partition,first_ts,last_ts,rows\n";
+        for (const auto& p : partitions) {
+            file << p.name << "," << p.first_ts << "," << p.last_ts << "," << p.rows << "\n";
+        }
+        if (!file) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+size_t enforce_retention(const std::string& data_dir, const std::string& symbol,
+                         std::vector<PartitionInfo>& partitions, std::int64_t cutoff_ts) {
+    size_t removed = 0;
+    std::error_code ec;
+    auto it = partitions.begin();
+    // 最新のパーティション（書き込み中）は残す
+    while (partitions.end() - it > 1 && it->last_ts < cutoff_ts) {
+        std::filesystem::remove(partition_csv_path(data_dir, symbol, it->name), ec);
+        std::filesystem::remove(partition_features_path(data_dir, symbol, it->name), ec);
+        ++it;
+        ++removed;
+    }
+    partitions.erase(partitions.begin(), it);
+    return removed;
+}
+
+std::uint64_t stored_market_rows(const std::string& data_dir, const std::string& symbol,
+                                 const std::vector<PartitionInfo>& partitions) {
+    std::uint64_t rows = 0;
+    for (const auto& path : feature_files(data_dir, symbol, partitions)) {
+        FeatureStoreReader reader;
+        if (reader.open(path)) rows += reader.row_count();
+    }
+    return rows;
+}
+
+std::uint64_t backfill_legacy_features(const std::string& data_dir, const std::string& symbol) {
+    std::string csv_path = legacy_csv_path(data_dir, symbol);
+    FeatureSourceStamp stamp;
+    if (!csv_source_stamp(csv_path, stamp)) return 0;
+
+    std::string path = legacy_features_path(data_dir, symbol);
+    bool has_features = false;
+    std::uint64_t feature_rows = 0;
+    {
+        FeatureStoreReader reader;
+        if (reader.open(path)) {
+            // 前に写してから CSV が変わっていなければ読まない
+            if (reader.source_stamp() == stamp) return 0;
+            has_features = true;
+            feature_rows = reader.row_count();
+        }
+    }
+
+    std::ifstream file(csv_path, std::ios::binary);
+    if (!file.is_open()) return 0;
+    std::string tmp_path = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::remove(tmp_path, ec);
+
+    std::uint64_t rows = 0;
+    bool ok;
+    {
+        FeatureStoreWriter writer;
+        // 1行はおよそ80バイト（足りなければ writer が広げる）
+        if (!writer.open(tmp_path, symbol, stamp.size / 80 + 1)) return 0;
+        std::string line;
+        FeatureRow row;
+        double last_ts = 0.0;
+        ok = true;
+        while (ok && std::getline(file, line)) {
+            // 読む側は timestamp の昇順を前提に二分探索するので、時刻が戻った行は捨てる
+            if (!parse_csv_row(line, row) || (rows > 0 && row[0] < last_ts)) continue;
+            last_ts = row[0];
+            writer.append(row);
+            // 列バッファが CSV 全体の大きさまで膨らまないよう、少しずつ書く
+            if (++rows % BACKFILL_BATCH_ROWS == 0) ok = writer.flush();
+        }
+        ok = ok && writer.flush() && writer.write_source_stamp(stamp);
+    }
+
+    if (!ok || rows <= feature_rows) {
+        std::filesystem::remove(tmp_path, ec);
+        // features.bin の方がそろっているときは、印だけ付けて次から CSV を読まないようにする
+        if (ok && has_features) {
+            FeatureStoreWriter writer;
+            if (writer.open(path, symbol)) writer.write_source_stamp(stamp);
+        }
+        return 0;
+    }
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmp_path, ec);
+        return 0;
+    }
+    return rows;
+}
+
+bool read_market_tail(const std::string& data_dir, const std::string& symbol, size_t n,
+                      std::vector<FeatureRow>& out) {
+    out.clear();
+    std::vector<PartitionInfo> partitions;
+    if (!load_manifest(data_dir, symbol, partitions)) return false;
+    std::vector<std::string> files = feature_files(data_dir, symbol, partitions);
+
+    // 新しいファイルから読み、足りたところでやめる（各ファイルの中身は古い順なので最後に並べ直す）
+    std::vector<std::vector<FeatureRow>> chunks;
+    size_t total = 0;
+    for (auto it = files.rbegin(); it != files.rend() && total < n; ++it) {
+        FeatureStoreReader reader;
+        if (!reader.open(*it)) continue;
+        std::uint64_t rows = reader.row_count();
+        std::uint64_t take = std::min<std::uint64_t>(rows, n - total);
+        chunks.emplace_back();
+        if (!reader.read(rows - take, rows, chunks.back())) return false;
+        total += chunks.back().size();
+    }
+    out.reserve(total);
+    for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) out.insert(out.end(), it->begin(), it->end());
+    return true;
+}
+
+bool read_market_range(const std::string& data_dir, const std::string& symbol, std::int64_t t0, std::int64_t t1,
+                       std::vector<FeatureRow>& out) {
+    out.clear();
+    std::vector<PartitionInfo> partitions;
+    if (!load_manifest(data_dir, symbol, partitions)) return false;
+
+    std::string legacy = legacy_features_path(data_dir, symbol);
+    std::vector<std::string> files;
+    if (std::filesystem::exists(legacy)) files.push_back(legacy); // 範囲が分からないので常に見る
+    for (const auto& p : partitions) {
+        // 書き込み中のパーティションは manifest の last_ts が遅れているので上限は見ない
+        bool newest = &p == &partitions.back();
+        if (p.first_ts > t1 || (!newest && p.last_ts < t0)) continue;
+        files.push_back(partition_features_path(data_dir, symbol, p.name));
+    }
+
+    for (const auto& path : files) {
+        FeatureStoreReader reader;
+        if (!reader.open(path)) continue;
+        std::uint64_t start = reader.lower_bound(static_cast<double>(t0));
+        std::uint64_t stop = reader.upper_bound(static_cast<double>(t1));
+        if (!reader.read(start, stop, out)) return false;
+    }
+    return true;
+}
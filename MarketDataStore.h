@@ -0,0 +1,80 @@
+#ifndef MARKETDATASTORE_H
+#define MARKETDATASTORE_H
+
+#include "FeatureStore.h"
+#include "RecorderOptions.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 時間で区切った市場データの置き場所
+ *
+ *   data/SYMBOL/manifest.csv                 パーティション一覧（partition,first_ts,last_ts,rows）
+ *   data/SYMBOL/YYYYMMDD[HH]_market_data.csv CSV（列は従来と同じ）
+ *   data/SYMBOL/YYYYMMDD[HH]_features.bin    同じ行の列形式ファイル（FeatureStore.h）
+ *
+ * パーティション名は UTC の日付（日単位）または日付+時（時間単位）。
+ * 読む側は manifest を見て、必要なパーティションだけを開く。
+ * 区切る前の data/SYMBOL_market_data.csv / SYMBOL_features.bin は最も古いパーティションとして扱う。
+ * 特徴量ファイルを書き始める前の行は CSV にしか無いので、起動時に backfill_legacy_features() で features.bin に写す。
+ * manifest はパーティションを切り替えたとき・終了時・RecorderOptions::manifest_interval ごとに書き直すので、
+ * 書き込み中のパーティションの rows / last_ts は実際より遅れていることがある。
+ */
+struct PartitionInfo {
+    std::string name;
+    std::int64_t first_ts = 0; // UNIX秒
+    std::int64_t last_ts = 0;
+    std::uint64_t rows = 0;
+};
+
+std::int64_t partition_seconds(PartitionPeriod period);
+// ts を含むパーティションの名前（"20261017" / "2026101718"）
+std::string partition_name(std::int64_t ts, PartitionPeriod period);
+
+std::string symbol_data_dir(const std::string& data_dir, const std::string& symbol);
+std::string partition_csv_path(const std::string& data_dir, const std::string& symbol, const std::string& name);
+std::string partition_features_path(const std::string& data_dir, const std::string& symbol, const std::string& name);
+
+// manifest が無ければ空で true。古い順に並ぶ
+bool load_manifest(const std::string& data_dir, const std::string& symbol, std::vector<PartitionInfo>& out);
+// 一時ファイルに書いてから置き換える
+bool save_manifest(const std::string& data_dir, const std::string& symbol, const std::vector<PartitionInfo>& partitions);
+
+/**
+ * @brief last_ts が cutoff_ts より古いパーティションのファイルを消し、manifest の一覧からも外す
+ * @return 消したパーティション数
+ */
+size_t enforce_retention(const std::string& data_dir, const std::string& symbol,
+                         std::vector<PartitionInfo>& partitions, std::int64_t cutoff_ts);
+
+/**
+ * @brief 学習側（read_market_tail / read_market_range）が読める行数
+ * 区切る前の features.bin と各パーティションの features.bin のヘッダーの row_count を足す（ファイル数回の読み込み）。
+ * CSV にしか無い行は数えないので、先に backfill_legacy_features() を呼んでおく
+ */
+std::uint64_t stored_market_rows(const std::string& data_dir, const std::string& symbol,
+                                 const std::vector<PartitionInfo>& partitions);
+
+/**
+ * @brief 区切る前の CSV の方が data/SYMBOL_features.bin より行が多ければ、CSV から features.bin を作り直す
+ * 読む側（read_market_tail / read_market_range）は features.bin だけを見るので、CSV にしか無い行をここで写す。
+ * 写したときの CSV の大きさと更新時刻を features.bin のヘッダーに残し、変わっていなければ CSV は読まない。
+ * CSV は1行ずつ読んで一時ファイルに書いてから置き換える
+ * @return 写した行数（作り直す必要が無ければ 0）
+ */
+std::uint64_t backfill_legacy_features(const std::string& data_dir, const std::string& symbol);
+
+/**
+ * @brief 最新の n 行（古い順）。新しいパーティションから順に、足りるまでしか開かない
+ */
+bool read_market_tail(const std::string& data_dir, const std::string& symbol, size_t n,
+                      std::vector<FeatureRow>& out);
+
+/**
+ * @brief timestamp が [t0, t1] の行（古い順）。範囲に重なるパーティションだけを開く
+ */
+bool read_market_range(const std::string& data_dir, const std::string& symbol, std::int64_t t0, std::int64_t t1,
+                       std::vector<FeatureRow>& out);
+
+#endif
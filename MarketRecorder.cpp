@@ -0,0 +1,295 @@
+#include "MarketRecorder.h"
+#include "TickPipeline.h"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+const char* CSV_HEADER = "timestamp,symbol,imbalance,imbalance_change,total_depth,price,btc_price,volatility,btc_pearson\n";
+
+// 1行の上限（数値9個 + 銘柄名）。これより短ければ途中で切れない
+constexpr size_t MAX_ROW = 512;
+
+char* put_fixed(char* p, char* end, double value) {
+    auto r = std::to_chars(p, end, value, std::chars_format::fixed, 6);
+    return r.ec == std::errc() ? r.ptr : p;
+}
+
+// btc_pearson 列は以前 btc_corr（騰落率の比、上限なし）だった。
+// 古い値が混ざると学習時のスケールと閾値の意味が崩れるので、ヘッダーの違うCSVは追記せずに
+// SYMBOL_market_data.csv.<UNIX秒> に退避する
+void archive_stale_csv(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string header;
+    if (!file.is_open() || !std::getline(file, header)) return;
+    file.close();
+    header += '\n';
+    if (header == CSV_HEADER) return;
+
+    long long ts = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string archived = filename + "." + std::to_string(ts);
+    std::error_code ec;
+    std::filesystem::rename(filename, archived, ec);
+    if (ec) {
+        std::cerr << "Cannot archive " << filename << ": " << ec.message() << std::endl;
+        return;
+    }
+    std::cout << "Archived " << filename << " (old column layout) to " << archived << std::endl;
+}
+
+} // namespace
+
+bool MarketRecorder::Lane::push(const MarketRecord& record) {
+    if (!ring_.try_push(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+    size_t depth = ring_.size();
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+MarketRecorder::MarketRecorder(const SymbolRegistry& registry, size_t lane_count, RecorderOptions options)
+    : registry_(registry), options_(std::move(options)), files_(registry.size()),
+      rows_(std::make_unique<std::atomic<std::uint64_t>[]>(registry.size())) {
+    if (lane_count == 0) lane_count = 1;
+    for (size_t k = 0; k < lane_count; ++k) lanes_.push_back(std::make_unique<Lane>());
+
+    // 行数の初期値は学習側が読める features.bin のヘッダーから取る（履歴の量によらずファイル数回の読み込み）
+    for (size_t id = 0; id < files_.size(); ++id) {
+        SymbolFile& f = files_[id];
+        const std::string& symbol = registry_.name(static_cast<SymbolId>(id));
+        f.buffer.reserve(options_.flush_bytes + MAX_ROW);
+        load_manifest(options_.directory, symbol, f.manifest);
+        archive_stale_csv(options_.directory + "/" + symbol + "_market_data.csv");
+        // 区切る前の CSV にしか無い行を、学習側が読む features.bin に写しておく
+        if (std::uint64_t copied = backfill_legacy_features(options_.directory, symbol)) {
+            std::cout << "Backfilled " << copied << " legacy rows of " << symbol << " into the feature store"
+                      << std::endl;
+        }
+
+        rows_[id].store(stored_market_rows(options_.directory, symbol, f.manifest), std::memory_order_relaxed);
+    }
+}
+
+void MarketRecorder::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void MarketRecorder::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+}
+
+bool MarketRecorder::rows_reached(const std::vector<SymbolId>& ids, std::uint64_t threshold) const {
+    for (SymbolId id : ids) {
+        if (id >= files_.size() || rows(id) < threshold) return false;
+    }
+    return true;
+}
+
+bool MarketRecorder::wait_for_rows(const std::vector<SymbolId>& ids, std::uint64_t threshold,
+                                   std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(rows_mutex_);
+    return rows_cv_.wait_for(lock, timeout, [&]() { return rows_reached(ids, threshold); });
+}
+
+MarketRecorder::Stats MarketRecorder::stats() const {
+    Stats s;
+    for (const auto& lane : lanes_) {
+        s.enqueued += lane->enqueued_.load(std::memory_order_relaxed);
+        s.dropped += lane->dropped_.load(std::memory_order_relaxed);
+        s.queue_depth += lane->ring_.size();
+        s.queue_high_water = std::max(s.queue_high_water, lane->high_water_.load(std::memory_order_relaxed));
+    }
+    s.written = written_.load(std::memory_order_relaxed);
+    s.flushes = flushes_.load(std::memory_order_relaxed);
+    s.write_latency = write_latency_.snapshot();
+    return s;
+}
+
+// 書き込みスレッド本体
+// 市場データは1銘柄1秒1行なので、空のときは10msスリープで十分
+void MarketRecorder::run() {
+    auto last_flush = std::chrono::steady_clock::now();
+    auto last_manifest = last_flush;
+    while (running_.load(std::memory_order_relaxed)) {
+        size_t n = drain();
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_flush >= options_.flush_interval) {
+            flush_all();
+            last_flush = now;
+        }
+        if (now - last_manifest >= options_.manifest_interval) {
+            save_manifests();
+            last_manifest = now;
+        }
+        if (n == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    drain();
+    flush_all();
+    save_manifests();
+}
+
+size_t MarketRecorder::drain() {
+    size_t n = 0;
+    for (auto& lane : lanes_) {
+        while (MarketRecord* record = lane->ring_.front()) {
+            append_row(*record);
+            if (listener_) listener_(*record);
+            lane->ring_.pop();
+            ++n;
+        }
+    }
+    return n;
+}
+
+void MarketRecorder::append_row(const MarketRecord& r) {
+    if (r.id >= files_.size()) return;
+    SymbolFile& f = files_[r.id];
+
+    char row[MAX_ROW];
+    char* end = row + sizeof(row);
+    char* p = std::to_chars(row, end, r.timestamp).ptr;
+    *p++ = ',';
+    const std::string& symbol = registry_.name(r.id);
+    size_t len = std::min(symbol.size(), MAX_ROW / 2);
+    p = std::copy(symbol.data(), symbol.data() + len, p);
+    for (double v : {r.imbalance, r.imbalance_change, r.total_depth, r.price, r.btc_price, r.volatility, r.btc_corr}) {
+        *p++ = ',';
+        p = put_fixed(p, end - 1, v);
+    }
+    *p++ = '\n';
+
+    // パーティションの境目をまたいだら、ファイルを切り替える
+    std::int64_t period = partition_seconds(options_.partition);
+    std::int64_t key = r.timestamp >= 0 ? r.timestamp / period : (r.timestamp - period + 1) / period;
+    if (!f.opened || key != f.partition_key) roll_symbol(r.id, r.timestamp, key);
+
+    f.buffer.append(row, p);
+    if (f.buffered_rows++ == 0) f.buffered_first_ts = r.timestamp;
+    f.buffered_last_ts = r.timestamp;
+    if (f.features.is_open()) {
+        f.features.append({static_cast<double>(r.timestamp), r.imbalance, r.imbalance_change, r.total_depth,
+                           r.price, r.btc_price, r.volatility, r.btc_corr});
+    }
+
+    if (f.buffer.size() >= options_.flush_bytes) flush_symbol(r.id);
+}
+
+void MarketRecorder::flush_symbol(SymbolId id) {
+    SymbolFile& f = files_[id];
+    if (f.buffer.empty()) return;
+
+    std::int64_t start = monotonic_ns();
+    if (f.file.is_open()) {
+        f.file.write(f.buffer.data(), static_cast<std::streamsize>(f.buffer.size()));
+        f.file.flush();
+    }
+    f.buffer.clear();
+    if (f.features.is_open()) f.features.flush();
+
+    // manifest の行数・時刻の範囲を進める
+    auto it = std::find_if(f.manifest.begin(), f.manifest.end(),
+                           [&](const PartitionInfo& p) { return p.name == f.partition; });
+    if (it != f.manifest.end()) {
+        if (it->rows == 0) it->first_ts = f.buffered_first_ts;
+        it->last_ts = std::max(it->last_ts, f.buffered_last_ts);
+        it->rows += f.buffered_rows;
+        f.manifest_dirty = true;
+    }
+    {
+        // 待っている側が条件を確認してから眠るまでの間に通知を落とさないよう、ロックを取って更新する
+        std::lock_guard<std::mutex> lock(rows_mutex_);
+        rows_[id].fetch_add(f.buffered_rows, std::memory_order_release);
+    }
+    rows_cv_.notify_all();
+
+    write_latency_.record(monotonic_ns() - start);
+    written_.fetch_add(f.buffered_rows, std::memory_order_relaxed);
+    f.buffered_rows = 0;
+    flushes_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 書き込み先を ts を含むパーティションに切り替える（最初の行のときも呼ぶ）
+// 前のパーティションの残りを書き切ってから閉じ、古いパーティションを保持期間に従って消す
+void MarketRecorder::roll_symbol(SymbolId id, std::int64_t ts, std::int64_t key) {
+    SymbolFile& f = files_[id];
+    const std::string& symbol = registry_.name(id);
+    flush_symbol(id);
+    if (f.file.is_open()) f.file.close();
+    f.features.close();
+
+    if (!f.opened) {
+        std::error_code ec;
+        std::filesystem::create_directories(symbol_data_dir(options_.directory, symbol), ec);
+        f.opened = true;
+    }
+    f.partition_key = key;
+    f.partition = partition_name(ts, options_.partition);
+    auto it = std::find_if(f.manifest.begin(), f.manifest.end(),
+                           [&](const PartitionInfo& p) { return p.name == f.partition; });
+    if (it == f.manifest.end()) {
+        PartitionInfo info;
+        info.name = f.partition;
+        info.first_ts = ts;
+        info.last_ts = ts;
+        f.manifest.push_back(info);
+        std::sort(f.manifest.begin(), f.manifest.end(),
+                  [](const PartitionInfo& a, const PartitionInfo& b) { return a.name < b.name; });
+    }
+
+    // ヘッダーは新しいファイルのときだけ
+    std::string filename = partition_csv_path(options_.directory, symbol, f.partition);
+    bool file_exists = std::filesystem::exists(filename);
+    f.file.open(filename, std::ios::app | std::ios::binary);
+    if (!f.file.is_open()) {
+        std::cerr << "Cannot open " << filename << std::endl;
+    } else if (!file_exists) {
+        f.file << CSV_HEADER;
+    }
+
+    if (options_.write_features) {
+        // 1秒1行なのでパーティションの秒数に少し余裕を足した容量（超えたら FeatureStoreWriter が広げる）
+        std::uint64_t capacity = static_cast<std::uint64_t>(partition_seconds(options_.partition)) * 9 / 8;
+        std::string features_path = partition_features_path(options_.directory, symbol, f.partition);
+        if (!f.features.open(features_path, symbol, capacity)) {
+            std::cerr << "Cannot open " << features_path << std::endl;
+        }
+    }
+
+    if (options_.retention_hours > 0) {
+        std::int64_t cutoff = ts - static_cast<std::int64_t>(options_.retention_hours) * 3600;
+        std::uint64_t before = 0, after = 0;
+        for (const auto& p : f.manifest) before += p.rows;
+        size_t removed = enforce_retention(options_.directory, symbol, f.manifest, cutoff);
+        if (removed > 0) {
+            for (const auto& p : f.manifest) after += p.rows;
+            std::lock_guard<std::mutex> lock(rows_mutex_);
+            rows_[id].fetch_sub(before - after, std::memory_order_release);
+            std::cout << "Removed " << removed << " old partition(s) of " << symbol << std::endl;
+        }
+    }
+    save_manifest(options_.directory, symbol, f.manifest);
+    f.manifest_dirty = false;
+}
+
+void MarketRecorder::flush_all() {
+    for (size_t id = 0; id < files_.size(); ++id) flush_symbol(static_cast<SymbolId>(id));
+}
+
+void MarketRecorder::save_manifests() {
+    for (size_t id = 0; id < files_.size(); ++id) {
+        SymbolFile& f = files_[id];
+        if (!f.manifest_dirty) continue;
+        save_manifest(options_.directory, registry_.name(static_cast<SymbolId>(id)), f.manifest);
+        f.manifest_dirty = false;
+    }
+}
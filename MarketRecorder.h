@@ -0,0 +1,148 @@
+#ifndef MARKETRECORDER_H
+#define MARKETRECORDER_H
+
+#include "FeatureStore.h"
+#include "LatencyHistogram.h"
+#include "MarketDataStore.h"
+#include "RecorderOptions.h"
+#include "SpscRing.h"
+#include "SymbolRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief data/SYMBOL_market_data.csv の1行分（固定長。ティック処理側はこれを積むだけ）
+ */
+struct MarketRecord {
+    SymbolId id = INVALID_SYMBOL;
+    std::int64_t timestamp = 0; // UNIX秒
+    double imbalance = 0.0;
+    double imbalance_change = 0.0;
+    double total_depth = 0.0;
+    double price = 0.0;
+    double btc_price = 0.0;
+    double volatility = 0.0;
+    double btc_corr = 0.0;
+};
+
+/**
+ * @brief 市場データCSVの非同期書き込み
+ * 書き手（シャードのストラテジースレッド）ごとに SPSC リングを1本持ち、
+ * 専用スレッドが取り出して銘柄ごとのバッファに std::to_chars で整形する。
+ * ファイルは開いたままにして、バッファが flush_bytes を超えるか flush_interval が経つとまとめて書く。
+ * ティック側は enqueue() で固定長のレコードをコピーするだけで、ファイルには触らない。
+ * 列の構成が今と違う既存のCSVは、構築時に SYMBOL_market_data.csv.<UNIX秒> へ退避する。
+ * 同じ行を列形式の特徴量ファイル（FeatureStore.h）にも書く。学習側はこちらを memmap で読む。
+ * ファイルは時間単位または日単位で区切り、manifest に行数と時刻の範囲を残す（MarketDataStore.h）。
+ * manifest の行数・時刻はメモリ上のものが正で、ファイルにはパーティションの切り替え・終了時・manifest_interval ごとに書く。
+ * 銘柄ごとに学習側が読める行数を数えていて（起動時は features.bin のヘッダーから）、ウォームアップは wait_for_rows() で待つ。
+ */
+class MarketRecorder {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    struct Stats {
+        std::uint64_t enqueued = 0;
+        std::uint64_t dropped = 0;     // リング満杯で捨てた数
+        std::uint64_t written = 0;     // ファイルに書いた行数
+        std::uint64_t flushes = 0;     // まとめ書きの回数
+        size_t queue_depth = 0;        // 全リングの現在の使用数
+        size_t queue_high_water = 0;   // リング1本あたりの使用数の最大値
+        LatencyHistogram::Snapshot write_latency; // まとめ書き1回（write + flush）の所要時間
+    };
+
+    /**
+     * @brief 1本の書き手に割り当てるキュー。push() はその書き手のスレッドからだけ呼ぶ
+     */
+    class Lane {
+    public:
+        bool push(const MarketRecord& record);
+
+    private:
+        friend class MarketRecorder;
+        SpscRing<MarketRecord, QUEUE_CAPACITY> ring_;
+        std::atomic<std::uint64_t> enqueued_{0};
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<size_t> high_water_{0};
+    };
+
+    /**
+     * @param lane_count 書き手の数（シャード数）
+     */
+    MarketRecorder(const SymbolRegistry& registry, size_t lane_count, RecorderOptions options = RecorderOptions{});
+    ~MarketRecorder() { stop(); }
+    MarketRecorder(const MarketRecorder&) = delete;
+    MarketRecorder& operator=(const MarketRecorder&) = delete;
+
+    void start();
+    // 残っているレコードを書き切ってからスレッドを止める
+    void stop();
+
+    Lane& lane(size_t k) { return *lanes_[k]; }
+    Stats stats() const;
+
+    // 書き込みスレッドが1行書くたびに呼ぶ（オンライン学習へ渡す用。start() の前に設定する）
+    void set_listener(std::function<void(const MarketRecord&)> listener) { listener_ = std::move(listener); }
+
+    // ディスクに書き終わった行数（保持期間で消した分は引く）。どのスレッドから呼んでもよい
+    std::uint64_t rows(SymbolId id) const { return rows_[id].load(std::memory_order_acquire); }
+
+    /**
+     * @brief ids のすべての銘柄が threshold 行に達するまで待つ（書き込みスレッドが書くたびに起こす）
+     * @return 揃ったら true、timeout が過ぎたら false
+     */
+    bool wait_for_rows(const std::vector<SymbolId>& ids, std::uint64_t threshold, std::chrono::milliseconds timeout);
+
+private:
+    struct SymbolFile {
+        std::ofstream file;
+        FeatureStoreWriter features;
+        std::string buffer;
+        size_t buffered_rows = 0;
+        std::int64_t buffered_first_ts = 0;
+        std::int64_t buffered_last_ts = 0;
+        bool opened = false;
+        std::int64_t partition_key = 0;          // ts / パーティションの秒数
+        std::string partition;                   // 書き込み中のパーティション名
+        std::vector<PartitionInfo> manifest;
+        bool manifest_dirty = false;             // manifest を進めたがまだファイルに書いていない
+    };
+
+    void run();
+    size_t drain();
+    void append_row(const MarketRecord& record);
+    void roll_symbol(SymbolId id, std::int64_t ts, std::int64_t key);
+    void flush_symbol(SymbolId id);
+    void flush_all();
+    void save_manifests();
+    bool rows_reached(const std::vector<SymbolId>& ids, std::uint64_t threshold) const;
+
+    const SymbolRegistry& registry_;
+    RecorderOptions options_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::vector<SymbolFile> files_;  // SymbolId で引く（書き込みスレッド専用）
+    std::function<void(const MarketRecord&)> listener_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // 銘柄ごとの行数と、それを待つスレッドへの通知
+    std::unique_ptr<std::atomic<std::uint64_t>[]> rows_;
+    std::mutex rows_mutex_;
+    std::condition_variable rows_cv_;
+
+    // 書き込みスレッドが書くカウンタ
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> flushes_{0};
+    LatencyHistogram write_latency_;
+};
+
+#endif
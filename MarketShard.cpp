@@ -0,0 +1,58 @@
+#include "MarketShard.h"
+#include <ixwebsocket/IXWebSocket.h>
+#include <algorithm>
+#include <iostream>
+
+MarketShard::MarketShard(const SymbolRegistry& registry, std::vector<SymbolId> symbol_ids,
+                         TickPipeline::Mode mode, TickPipeline::Handler handler)
+    : registry_(registry),
+      symbol_ids_(std::move(symbol_ids)),
+      pipeline_(registry, mode, std::move(handler), symbol_ids_),
+      socket_(std::make_unique<ix::WebSocket>()) {}
+
+MarketShard::~MarketShard() {
+    stop();
+}
+
+void MarketShard::start(const std::string& base_url, int cpu) {
+    pipeline_.start(cpu);
+
+    socket_->setUrl(make_stream_url(base_url, registry_, symbol_ids_));
+    // 受信スレッドでは時刻を打ってパイプラインに積むだけ（ディスクI/Oやモデル再読込で受信が止まらないように）
+    socket_->setOnMessageCallback([this](const ix::WebSocketMessagePtr& msg) {
+        if (msg->type == ix::WebSocketMessageType::Message) {
+            pipeline_.push_frame(msg->str, monotonic_ns());
+        } else if (msg->type == ix::WebSocketMessageType::Error) {
+            std::cerr << "WebSocket error: " << msg->errorInfo.reason << std::endl;
+        }
+    });
+    socket_->start();
+}
+
+void MarketShard::stop() {
+    socket_->stop();
+    pipeline_.stop();
+}
+
+std::vector<std::vector<SymbolId>> partition_symbols(size_t symbol_count, int shard_count) {
+    if (shard_count < 1) shard_count = 1;
+    std::vector<std::vector<SymbolId>> shards(static_cast<size_t>(shard_count));
+    for (size_t id = 0; id < symbol_count; ++id) {
+        shards[id % shards.size()].push_back(static_cast<SymbolId>(id));
+    }
+    return shards;
+}
+
+std::string make_stream_url(const std::string& base_url, const SymbolRegistry& registry,
+                            const std::vector<SymbolId>& symbol_ids) {
+    std::string url = base_url + "?streams=";
+    for (size_t i = 0; i < symbol_ids.size(); ++i) {
+        std::string lower_symbol = registry.name(symbol_ids[i]);
+        std::transform(lower_symbol.begin(), lower_symbol.end(), lower_symbol.begin(), ::tolower);
+        url += lower_symbol + "@bookTicker";
+        if (i < symbol_ids.size() - 1) {
+            url += "/";
+        }
+    }
+    return url;
+}
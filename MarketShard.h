@@ -0,0 +1,50 @@
+#ifndef MARKETSHARD_H
+#define MARKETSHARD_H
+
+#include "SymbolRegistry.h"
+#include "TickPipeline.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ix { class WebSocket; }
+
+/**
+ * @brief 銘柄の一部を担当する WebSocket 接続1本とパイプライン1本の組
+ * 接続ごとに受信スレッドとストラテジースレッドが独立するので、銘柄数を増やしても
+ * 1本のソケットスレッドに全銘柄が詰まらない。
+ */
+class MarketShard {
+public:
+    MarketShard(const SymbolRegistry& registry, std::vector<SymbolId> symbol_ids,
+                TickPipeline::Mode mode, TickPipeline::Handler handler);
+    ~MarketShard();
+    MarketShard(const MarketShard&) = delete;
+    MarketShard& operator=(const MarketShard&) = delete;
+
+    /**
+     * @brief ストラテジースレッドを起動し、担当銘柄の結合ストリームに接続する
+     * @param base_url "wss://stream.binance.com/stream" など（?streams= は付けない）
+     * @param cpu ストラテジースレッドを固定するCPU（負ならピン留めしない）
+     */
+    void start(const std::string& base_url, int cpu);
+    void stop();
+
+    const std::vector<SymbolId>& symbol_ids() const { return symbol_ids_; }
+    TickPipeline::Stats stats() const { return pipeline_.stats(); }
+
+private:
+    const SymbolRegistry& registry_;
+    std::vector<SymbolId> symbol_ids_;
+    TickPipeline pipeline_;
+    std::unique_ptr<ix::WebSocket> socket_;
+};
+
+// 銘柄を shard_count 個に振り分ける（ID順のラウンドロビン）
+std::vector<std::vector<SymbolId>> partition_symbols(size_t symbol_count, int shard_count);
+
+// base_url?streams=xxx@bookTicker/yyy@bookTicker 形式の結合ストリームURLを作る
+std::string make_stream_url(const std::string& base_url, const SymbolRegistry& registry,
+                            const std::vector<SymbolId>& symbol_ids);
+
+#endif
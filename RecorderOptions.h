@@ -0,0 +1,22 @@
+#ifndef RECORDEROPTIONS_H
+#define RECORDEROPTIONS_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// 市場データファイルを区切る単位（UTC）
+enum class PartitionPeriod { Hour, Day };
+
+// 市場データの書き込み先・区切り・保持期間（MarketRecorder）
+struct RecorderOptions {
+    std::string directory = "data";
+    size_t flush_bytes = 64 * 1024;                 // 銘柄ごとのバッファがこれを超えたら書く
+    std::chrono::milliseconds flush_interval{1000}; // 最後に書いてからこれだけ経ったら全部書く
+    std::chrono::seconds manifest_interval{30};     // manifest を書き直す間隔（パーティションの切り替えと終了時は必ず書く）
+    bool write_features = true;                     // CSV と同じ行を列形式の features.bin にも書く
+    PartitionPeriod partition = PartitionPeriod::Day; // ファイルを区切る単位（UTC）
+    int retention_hours = 24 * 7;                   // これより古いパーティションを消す（0 なら消さない）
+};
+
+#endif
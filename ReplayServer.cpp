@@ -0,0 +1,347 @@
+// Binance 結合ストリームのスタンドイン（ローカル・リプレイサーバー）
+// 記録済みのティックを main.cpp が受け取るのと同じ {"stream":…,"data":{…}} 形式で配信する。
+// ネットワークなしでパイプライン全体のスループット・遅延を測るためのツール。
+//
+// 使い方:
+//   My-MM-replay [--port 9001] [--data data] [--speed 1] [--loop]
+//   My-MM.exe --url ws://127.0.0.1:9001/stream
+//
+//   --data DIR      DIR/SYMBOL/*_market_data.csv（と区切る前の DIR/SYMBOL_market_data.csv）を再生する（既定）
+//   --speed X       1 = 実時間、N = N倍速、0 = 待たずに最速
+//   --loop          最後まで再生したら先頭から繰り返す
+//
+// CSV には板の価格・数量そのものは残っていないので、
+// price / total_depth(USDT) / imbalance から b/a/B/A を逆算する（小数8桁に丸める範囲で mid と imbalance が元の値に一致する）。
+#include <ixwebsocket/IXWebSocketServer.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+
+namespace {
+
+struct ReplayOptions {
+    int port = 9001;
+    std::string host = "127.0.0.1";
+    std::string data_dir = "data";
+    double speed = 1.0;
+    bool loop = false;
+};
+
+// 再生する1イベント
+struct ReplayEvent {
+    double ts_sec = 0.0; // 記録時刻（秒）
+    std::string frame;   // 送信する結合ストリーム形式のJSON
+};
+
+bool parse_double(std::string_view text, double& out) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+void append_fixed(std::string& out, double value) {
+    char buf[64];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, 8);
+    out.append(buf, ec == std::errc() ? ptr : buf);
+}
+
+std::string make_envelope(const std::string& symbol, long long update_id,
+                          double bid, double bid_qty, double ask, double ask_qty) {
+    std::string f;
+    f.reserve(200);
+    f += "{\"stream\":\"";
+    f += to_lower(symbol);
+    f += "@bookTicker\",\"data\":{\"u\":";
+    f += std::to_string(update_id);
+    f += ",\"s\":\"";
+    f += symbol;
+    f += "\",\"b\":\"";
+    append_fixed(f, bid);
+    f += "\",\"B\":\"";
+    append_fixed(f, bid_qty);
+    f += "\",\"a\":\"";
+    append_fixed(f, ask);
+    f += "\",\"A\":\"";
+    append_fixed(f, ask_qty);
+    f += "\"}}";
+    return f;
+}
+
+// 銘柄の market_data.csv を古い順に（区切る前の1ファイル → パーティション名順）
+std::vector<std::string> market_data_files(const std::string& data_dir, const std::string& symbol) {
+    const std::string suffix = "_market_data.csv";
+    std::vector<std::string> files;
+    std::string legacy = data_dir + "/" + symbol + suffix;
+    if (std::filesystem::exists(legacy)) files.push_back(legacy);
+
+    std::vector<std::string> partitions;
+    std::string dir = data_dir + "/" + symbol;
+    if (std::filesystem::is_directory(dir)) {
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                partitions.push_back(entry.path().string());
+            }
+        }
+    }
+    std::sort(partitions.begin(), partitions.end());
+    files.insert(files.end(), partitions.begin(), partitions.end());
+    return files;
+}
+
+// 銘柄ごとの market_data.csv を時刻順にマージして再生する
+class CsvSource {
+public:
+    CsvSource(const std::string& data_dir, const std::vector<std::string>& symbols) {
+        for (const auto& symbol : symbols) {
+            auto reader = std::make_unique<Reader>();
+            reader->symbol = symbol;
+            reader->files = market_data_files(data_dir, symbol);
+            if (reader->files.empty()) {
+                std::cerr << "No market data for " << symbol << std::endl;
+                continue;
+            }
+            if (advance(*reader)) heap_.push(reader.get());
+            readers_.push_back(std::move(reader));
+        }
+    }
+
+    bool next(ReplayEvent& out) {
+        if (heap_.empty()) return false;
+        Reader* r = heap_.top();
+        heap_.pop();
+        out = std::move(r->pending);
+        if (advance(*r)) heap_.push(r);
+        return true;
+    }
+
+private:
+    struct Reader {
+        std::string symbol;
+        std::vector<std::string> files; // 古い順
+        size_t next_file = 0;
+        std::ifstream file;
+        ReplayEvent pending;
+        long long update_id = 0;
+    };
+    struct Later {
+        bool operator()(const Reader* a, const Reader* b) const { return a->pending.ts_sec > b->pending.ts_sec; }
+    };
+
+    // 今のファイルを読み終えたら次のパーティションを開く
+    bool next_line(Reader& r, std::string& line) {
+        while (!std::getline(r.file, line)) {
+            if (r.next_file >= r.files.size()) return false;
+            r.file.close();
+            r.file.clear();
+            r.file.open(r.files[r.next_file++]);
+        }
+        return true;
+    }
+
+    // 次の有効な行を読み、フレームに変換して pending に置く
+    bool advance(Reader& r) {
+        std::string line;
+        while (next_line(r, line)) {
+            // timestamp,symbol,imbalance,imbalance_change,total_depth,price,btc_price,volatility,btc_pearson
+            std::vector<std::string_view> cols;
+            std::string_view rest(line);
+            while (true) {
+                size_t comma = rest.find(',');
+                cols.push_back(rest.substr(0, comma));
+                if (comma == std::string_view::npos) break;
+                rest.remove_prefix(comma + 1);
+            }
+            double ts, imbalance, depth_usdt, price;
+            if (cols.size() < 6 || !parse_double(cols[0], ts) || !parse_double(cols[2], imbalance) ||
+                !parse_double(cols[4], depth_usdt) || !parse_double(cols[5], price) || price <= 0.0) {
+                continue; // ヘッダーや壊れた行
+            }
+            double total_qty = depth_usdt / price;
+            double bid_qty = total_qty * (1.0 + imbalance) / 2.0;
+            double ask_qty = total_qty * (1.0 - imbalance) / 2.0;
+            double half_spread = price * 0.00001;
+            r.pending.ts_sec = ts;
+            r.pending.frame = make_envelope(r.symbol, ++r.update_id,
+                                            price - half_spread, bid_qty, price + half_spread, ask_qty);
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Reader>> readers_;
+    std::priority_queue<Reader*, std::vector<Reader*>, Later> heap_;
+};
+
+// 接続URLの ?streams=ethusdt@bookTicker/... から銘柄を取り出す
+std::vector<std::string> symbols_from_uri(const std::string& uri) {
+    std::vector<std::string> symbols;
+    size_t pos = uri.find("streams=");
+    if (pos == std::string::npos) return symbols;
+    std::string_view rest = std::string_view(uri).substr(pos + 8);
+    rest = rest.substr(0, rest.find('&'));
+    while (!rest.empty()) {
+        size_t slash = rest.find('/');
+        std::string_view stream = rest.substr(0, slash);
+        std::string symbol(stream.substr(0, stream.find('@')));
+        std::transform(symbol.begin(), symbol.end(), symbol.begin(), ::toupper);
+        if (!symbol.empty()) symbols.push_back(symbol);
+        if (slash == std::string_view::npos) break;
+        rest.remove_prefix(slash + 1);
+    }
+    return symbols;
+}
+
+// data ディレクトリにある全銘柄（SYMBOL_market_data.csv または manifest のある SYMBOL/）
+std::vector<std::string> symbols_in_dir(const std::string& data_dir) {
+    std::set<std::string> symbols;
+    const std::string suffix = "_market_data.csv";
+    if (!std::filesystem::exists(data_dir)) return {};
+    for (const auto& entry : std::filesystem::directory_iterator(data_dir)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_directory() && std::filesystem::exists(entry.path() / "manifest.csv")) {
+            symbols.insert(name);
+        } else if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            symbols.insert(name.substr(0, name.size() - suffix.size()));
+        }
+    }
+    return std::vector<std::string>(symbols.begin(), symbols.end());
+}
+
+std::unique_ptr<CsvSource> open_source(const ReplayOptions& opts, const std::vector<std::string>& symbols) {
+    return std::make_unique<CsvSource>(opts.data_dir,
+                                       symbols.empty() ? symbols_in_dir(opts.data_dir) : symbols);
+}
+
+// 1接続ぶんの再生（接続ごとに専用スレッド）
+void replay_to_client(const ReplayOptions& opts, std::vector<std::string> symbols,
+                      ix::WebSocket& ws, const std::atomic<bool>& stop) {
+    do {
+        auto source = open_source(opts, symbols);
+        ReplayEvent ev;
+        bool first = true;
+        double first_ts = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        long long sent = 0;
+
+        while (!stop.load() && source->next(ev)) {
+            if (first) {
+                first_ts = ev.ts_sec;
+                first = false;
+            }
+            if (opts.speed > 0.0) {
+                auto offset = std::chrono::duration<double>((ev.ts_sec - first_ts) / opts.speed);
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+            }
+            if (!ws.sendText(ev.frame).success) return; // 切断された
+            ++sent;
+        }
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Replayed " << sent << " frames in " << elapsed << " s ("
+                  << (elapsed > 0 ? sent / elapsed : 0.0) << " frames/s)" << std::endl;
+    } while (opts.loop && !stop.load());
+}
+
+bool parse_options(int argc, char* argv[], ReplayOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--port" && has_value) opts.port = std::atoi(argv[++i]);
+        else if (arg == "--host" && has_value) opts.host = argv[++i];
+        else if (arg == "--data" && has_value) opts.data_dir = argv[++i];
+        else if (arg == "--speed" && has_value) opts.speed = std::atof(argv[++i]);
+        else if (arg == "--loop") opts.loop = true;
+        else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ReplayOptions opts;
+    if (!parse_options(argc, argv, opts)) return 1;
+
+    #ifdef _WIN32
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+            std::cerr << "WSAStartup failed." << std::endl;
+            return 1;
+        }
+    #endif
+
+    // 接続ごとの再生スレッド（Close で止めて join する）
+    struct Session {
+        std::atomic<bool> stop{false};
+        std::thread thread;
+    };
+    std::mutex sessions_mutex;
+    std::map<std::string, std::unique_ptr<Session>> sessions;
+
+    ix::WebSocketServer server(opts.port, opts.host);
+    server.disablePerMessageDeflate();
+    server.setOnClientMessageCallback([&](std::shared_ptr<ix::ConnectionState> state, ix::WebSocket& ws,
+                                          const ix::WebSocketMessagePtr& msg) {
+        if (msg->type == ix::WebSocketMessageType::Open) {
+            std::vector<std::string> symbols = symbols_from_uri(msg->openInfo.uri);
+            std::cout << "Client connected: " << msg->openInfo.uri << " (" << symbols.size() << " symbols)" << std::endl;
+            auto session = std::make_unique<Session>();
+            Session* s = session.get();
+            s->thread = std::thread([&opts, symbols, &ws, s]() { replay_to_client(opts, symbols, ws, s->stop); });
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            sessions[state->getId()] = std::move(session);
+        } else if (msg->type == ix::WebSocketMessageType::Close) {
+            std::unique_ptr<Session> session;
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex);
+                auto it = sessions.find(state->getId());
+                if (it == sessions.end()) return;
+                session = std::move(it->second);
+                sessions.erase(it);
+            }
+            session->stop = true;
+            if (session->thread.joinable()) session->thread.join();
+            std::cout << "Client disconnected" << std::endl;
+        }
+    });
+
+    auto res = server.listen();
+    if (!res.first) {
+        std::cerr << "Listen failed: " << res.second << std::endl;
+        return 1;
+    }
+    server.start();
+    std::cout << "Replay server listening on ws://" << opts.host << ":" << opts.port << "/stream"
+              << " (speed " << (opts.speed > 0.0 ? std::to_string(opts.speed) + "x" : std::string("max")) << ")" << std::endl;
+    server.wait();
+
+    #ifdef _WIN32
+        WSACleanup();
+    #endif
+    return 0;
+}
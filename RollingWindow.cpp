@@ -0,0 +1,189 @@
+#include "RollingWindow.h"
+#include <algorithm>
+#include <cmath>
+
+RollingWindow::RollingWindow(size_t capacity) : buffer_(capacity > 0 ? capacity : 1, 0.0) {}
+
+void RollingWindow::push(double value) {
+    if (count_ == 0) anchor_ = value;
+
+    double d = value - anchor_;
+    if (count_ == buffer_.size()) {
+        // 窓から押し出される値を和から引く
+        double old = buffer_[head_] - anchor_;
+        sum_ -= old;
+        sum_sq_ -= old * old;
+    } else {
+        ++count_;
+    }
+    buffer_[head_] = value;
+    head_ = (head_ + 1) % buffer_.size();
+    sum_ += d;
+    sum_sq_ += d * d;
+
+    // 一周ごとに基準を取り直して誤差の蓄積を消す
+    if (++since_recenter_ >= buffer_.size()) recenter();
+}
+
+void RollingWindow::recenter() {
+    since_recenter_ = 0;
+    if (count_ == 0) return;
+    anchor_ = mean();
+    sum_ = 0.0;
+    sum_sq_ = 0.0;
+    size_t start = (head_ + buffer_.size() - count_) % buffer_.size();
+    for (size_t i = 0; i < count_; ++i) {
+        double d = buffer_[(start + i) % buffer_.size()] - anchor_;
+        sum_ += d;
+        sum_sq_ += d * d;
+    }
+}
+
+double RollingWindow::mean() const {
+    if (count_ == 0) return 0.0;
+    return anchor_ + sum_ / static_cast<double>(count_);
+}
+
+double RollingWindow::variance() const {
+    if (count_ == 0) return 0.0;
+    double n = static_cast<double>(count_);
+    double m = sum_ / n;
+    double var = sum_sq_ / n - m * m;
+    return var > 0.0 ? var : 0.0;
+}
+
+double RollingWindow::stddev() const {
+    return std::sqrt(variance());
+}
+
+// --- TimeBucketWindow ---
+
+TimeBucketWindow::TimeBucketWindow(size_t window_buckets, std::int64_t bucket_ns)
+    : completed_(window_buckets > 1 ? window_buckets - 1 : 1), bucket_ns_(bucket_ns > 0 ? bucket_ns : 1) {}
+
+void TimeBucketWindow::update(std::int64_t now_ns, double value) {
+    std::int64_t bucket = now_ns / bucket_ns_;
+    if (has_current_ && bucket > current_bucket_) {
+        // 終わったバケットを確定し、ティックの無かったバケットは直前の値で埋める
+        std::int64_t elapsed = bucket - current_bucket_;
+        std::int64_t fill = std::min<std::int64_t>(elapsed, static_cast<std::int64_t>(completed_.capacity()));
+        for (std::int64_t i = 0; i < fill; ++i) completed_.push(current_);
+    }
+    if (!has_current_ || bucket >= current_bucket_) {
+        current_bucket_ = bucket;
+    }
+    current_ = value;
+    has_current_ = true;
+}
+
+// 確定分（平均 m_c・分散 v_c・n_c 個）に現在値 x を1つ足した統計。
+// 偏差どうしで合成するので、価格の大きい銘柄でも桁落ちしない
+double TimeBucketWindow::mean() const {
+    if (!has_current_) return 0.0;
+    double n_c = static_cast<double>(completed_.size());
+    return (completed_.mean() * n_c + current_) / (n_c + 1.0);
+}
+
+double TimeBucketWindow::stddev() const {
+    if (!has_current_) return 0.0;
+    double n_c = static_cast<double>(completed_.size());
+    double m = mean();
+    double dc = completed_.mean() - m;
+    double dx = current_ - m;
+    double var = (n_c * (completed_.variance() + dc * dc) + dx * dx) / (n_c + 1.0);
+    return var > 0.0 ? std::sqrt(var) : 0.0;
+}
+
+// --- PairMoments ---
+
+namespace {
+// 誤差で負になった分散や、完全に動いていない系列を 0 とみなす
+constexpr double MIN_VARIANCE = 1e-24;
+}
+
+double PairMoments::correlation() const {
+    if (n < 2.0) return 0.0;
+    double vx = sxx / n - (sx / n) * (sx / n);
+    double vy = syy / n - (sy / n) * (sy / n);
+    if (vx < MIN_VARIANCE || vy < MIN_VARIANCE) return 0.0;
+    double cov = sxy / n - (sx / n) * (sy / n);
+    double r = cov / std::sqrt(vx * vy);
+    return std::clamp(r, -1.0, 1.0);
+}
+
+double PairMoments::beta() const {
+    if (n < 2.0) return 0.0;
+    double vy = syy / n - (sy / n) * (sy / n);
+    if (vy < MIN_VARIANCE) return 0.0;
+    double cov = sxy / n - (sx / n) * (sy / n);
+    return cov / vy;
+}
+
+// --- RollingCovariance ---
+
+RollingCovariance::RollingCovariance(size_t capacity)
+    : xs_(capacity > 0 ? capacity : 1, 0.0), ys_(capacity > 0 ? capacity : 1, 0.0) {}
+
+void RollingCovariance::push(double x, double y) {
+    if (count_ == xs_.size()) {
+        double ox = xs_[head_], oy = ys_[head_];
+        m_.n -= 1.0;
+        m_.sx -= ox; m_.sy -= oy;
+        m_.sxx -= ox * ox; m_.syy -= oy * oy; m_.sxy -= ox * oy;
+    } else {
+        ++count_;
+    }
+    xs_[head_] = x;
+    ys_[head_] = y;
+    head_ = (head_ + 1) % xs_.size();
+    m_.add(x, y);
+
+    if (++since_resum_ >= xs_.size()) resum();
+}
+
+void RollingCovariance::resum() {
+    since_resum_ = 0;
+    m_ = PairMoments{};
+    size_t start = (head_ + xs_.size() - count_) % xs_.size();
+    for (size_t i = 0; i < count_; ++i) {
+        size_t k = (start + i) % xs_.size();
+        m_.add(xs_[k], ys_[k]);
+    }
+}
+
+// --- TimeBucketCorrelation ---
+
+// 価格 N 個の窓には収益率が N-1 個あり、そのうち最後の1個は現在バケットの暫定分
+TimeBucketCorrelation::TimeBucketCorrelation(size_t window_buckets, std::int64_t bucket_ns)
+    : returns_(window_buckets > 2 ? window_buckets - 2 : 1), bucket_ns_(bucket_ns > 0 ? bucket_ns : 1) {}
+
+void TimeBucketCorrelation::update(std::int64_t now_ns, double x_price, double y_price) {
+    std::int64_t bucket = now_ns / bucket_ns_;
+    if (has_current_ && bucket > current_bucket_) {
+        // 現在バケットを確定する
+        if (has_last_ && last_x_ > 0.0 && last_y_ > 0.0) {
+            returns_.push(cur_x_ / last_x_ - 1.0, cur_y_ / last_y_ - 1.0);
+        }
+        // ティックの無かったバケットは価格据え置き（収益率0）
+        std::int64_t empty = std::min<std::int64_t>(bucket - current_bucket_ - 1,
+                                                     static_cast<std::int64_t>(returns_.capacity()));
+        for (std::int64_t i = 0; i < empty; ++i) returns_.push(0.0, 0.0);
+        last_x_ = cur_x_;
+        last_y_ = cur_y_;
+        has_last_ = true;
+    }
+    if (!has_current_ || bucket >= current_bucket_) {
+        current_bucket_ = bucket;
+    }
+    cur_x_ = x_price;
+    cur_y_ = y_price;
+    has_current_ = true;
+}
+
+PairMoments TimeBucketCorrelation::moments() const {
+    PairMoments m = returns_.moments();
+    if (has_last_ && last_x_ > 0.0 && last_y_ > 0.0) {
+        m.add(cur_x_ / last_x_ - 1.0, cur_y_ / last_y_ - 1.0);
+    }
+    return m;
+}
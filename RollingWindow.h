@@ -0,0 +1,146 @@
+#ifndef ROLLINGWINDOW_H
+#define ROLLINGWINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 固定長のリングバッファに、和と二乗和を差分更新で持つ移動窓
+ * push() も mean()/stddev() も O(1)。
+ * 桁落ちを防ぐため、値は基準値 anchor からの差で積算し、
+ * 窓が一周するたびに現在の平均を新しい基準にして和を計算し直す（償却 O(1)）。
+ */
+class RollingWindow {
+public:
+    explicit RollingWindow(size_t capacity);
+
+    void push(double value);
+
+    size_t size() const { return count_; }
+    size_t capacity() const { return buffer_.size(); }
+    bool full() const { return count_ == buffer_.size(); }
+
+    // 最も古い値・最も新しい値（size() > 0 のときのみ）
+    double front() const { return buffer_[(head_ + buffer_.size() - count_) % buffer_.size()]; }
+    double back() const { return buffer_[(head_ + buffer_.size() - 1) % buffer_.size()]; }
+
+    double mean() const;
+    // 母標準偏差（n で割る）
+    double stddev() const;
+    double variance() const;
+
+private:
+    void recenter();
+
+    std::vector<double> buffer_;
+    size_t head_ = 0;   // 次に書く位置
+    size_t count_ = 0;
+    size_t since_recenter_ = 0;
+    double anchor_ = 0.0; // 積算の基準値
+    double sum_ = 0.0;    // Σ(x - anchor)
+    double sum_sq_ = 0.0; // Σ(x - anchor)^2
+};
+
+/**
+ * @brief 実時間で区切った移動窓（例: 1秒バケット × 60個 = 直近60秒）
+ * 各バケットにはその時間内の最後の値を持つ。ティックが来ない時間帯は直前の値で埋めるので、
+ * 窓が表す時間はフィードの混み具合に関係なく一定になる。
+ * 確定したバケットは RollingWindow に入れ、未確定の現在バケットは統計に暫定値として足す。
+ * update() は O(1)（空白の時間を埋める分だけ追加で最大 window 回）。
+ */
+class TimeBucketWindow {
+public:
+    TimeBucketWindow(size_t window_buckets, std::int64_t bucket_ns);
+
+    // now_ns は単調増加時計（monotonic_ns）
+    void update(std::int64_t now_ns, double value);
+
+    // 現在バケットを含むバケット数
+    size_t size() const { return has_current_ ? completed_.size() + 1 : 0; }
+    double front() const { return completed_.size() > 0 ? completed_.front() : current_; }
+    double back() const { return current_; }
+
+    double mean() const;
+    double stddev() const;
+
+private:
+    RollingWindow completed_;   // 確定したバケット（window - 1 個）
+    std::int64_t bucket_ns_;
+    std::int64_t current_bucket_ = 0;
+    double current_ = 0.0;
+    bool has_current_ = false;
+};
+
+/**
+ * @brief 2系列（x, y）の和・二乗和・積和。相関係数とベータ（x の y に対する回帰係数）を出す
+ */
+struct PairMoments {
+    double n = 0.0;
+    double sx = 0.0, sy = 0.0;
+    double sxx = 0.0, syy = 0.0, sxy = 0.0;
+
+    void add(double x, double y) {
+        n += 1.0;
+        sx += x; sy += y;
+        sxx += x * x; syy += y * y; sxy += x * y;
+    }
+    // ピアソン相関（どちらかの分散が0なら 0.0）
+    double correlation() const;
+    // cov(x, y) / var(y)（y の分散が0なら 0.0）
+    double beta() const;
+};
+
+/**
+ * @brief (x, y) の組を固定長で持ち、PairMoments を差分更新する移動窓
+ * 収益率のように0付近の値を想定して基準値は取らない。誤差の蓄積は一周ごとの再計算で消す
+ */
+class RollingCovariance {
+public:
+    explicit RollingCovariance(size_t capacity);
+
+    void push(double x, double y);
+
+    size_t size() const { return count_; }
+    size_t capacity() const { return xs_.size(); }
+    const PairMoments& moments() const { return m_; }
+
+private:
+    void resum();
+
+    std::vector<double> xs_;
+    std::vector<double> ys_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t since_resum_ = 0;
+    PairMoments m_;
+};
+
+/**
+ * @brief 1秒バケットの収益率で見た、ある銘柄（x）と基準銘柄（y）の相関・ベータ
+ * TimeBucketWindow と同じく各バケットの最後の価格を使い、ティックの無いバケットは収益率0で埋める。
+ * 確定したバケット間の収益率は RollingCovariance に入れ、現在バケットの収益率は暫定値として足す。
+ * update() は O(1)（空白の時間を埋める分だけ追加で最大 window 回）。
+ */
+class TimeBucketCorrelation {
+public:
+    TimeBucketCorrelation(size_t window_buckets, std::int64_t bucket_ns);
+
+    void update(std::int64_t now_ns, double x_price, double y_price);
+
+    // 窓内の収益率の数（現在バケットの暫定分を含む）
+    size_t size() const { return returns_.size() + (has_last_ ? 1 : 0); }
+
+    PairMoments moments() const;
+
+private:
+    RollingCovariance returns_; // 確定したバケット間の収益率
+    std::int64_t bucket_ns_;
+    std::int64_t current_bucket_ = 0;
+    double cur_x_ = 0.0, cur_y_ = 0.0;   // 現在バケットの最後の価格
+    double last_x_ = 0.0, last_y_ = 0.0; // 直前に確定したバケットの価格
+    bool has_current_ = false;
+    bool has_last_ = false;
+};
+
+#endif
@@ -1,110 +1,236 @@
 #include "SOMEvaluator.h"
-#include <fstream>
-#include <sstream>
+#include "SOMModelFile.h"
 #include <cmath>
 #include <algorithm> // std::clamp用
-#include <iostream>
+#include <thread>
+
+namespace {
+
+// バリデーション（グリッドと特徴量数はモデルが持つので、形が揃っているかだけ見る）
+bool accept_model(const SOMModel& model) {
+    return model.node_count > 0 && model.grid_width * model.grid_height == model.node_count &&
+           model.feature_count > 0 && model.kernel != nullptr;
+}
+
+} // namespace
 
 bool SOMEvaluator::loadModel(const std::string& weights_csv, 
                              const std::string& expectancy_csv, 
                              const std::string& params_csv,
                              const std::string& risk_csv) {
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    map_weights.clear();
-    expectancy_map.clear();
-    risk_map.clear();
-    mins.clear();
-    maxs.clear();
-
-    std::string line, val;
-
-    // 1. 重みのロード
-    std::ifstream wf(weights_csv);
-    if (!wf.is_open()) return false;
-    while (std::getline(wf, line)) {
-        std::vector<double> row;
-        std::stringstream ss(line);
-        while (std::getline(ss, val, ',')) { row.push_back(std::stod(val)); }
-        if (!row.empty()) map_weights.push_back(row);
+    // 組み立ては推論を止めずに行い、すべて揃ってから差し替える
+    auto next = std::make_unique<SOMModel>();
+    if (!load_som_model_csv(weights_csv, expectancy_csv, params_csv, risk_csv, *next) || !accept_model(*next)) {
+        return false;
     }
+    publish(std::move(next));
+    return true;
+}
 
-    // 2. 期待値(Expectancy)のロード
-    std::ifstream sf(expectancy_csv);
-    if (!sf.is_open()) return false;
-    while (std::getline(sf, line)) {
-        if (!line.empty()) expectancy_map.push_back(std::stod(line));
-    }
+bool SOMEvaluator::loadModelFile(const std::string& model_path) {
+    auto next = std::make_unique<SOMModel>();
+    if (!load_som_model(model_path, *next) || !accept_model(*next)) return false;
+    publish(std::move(next));
+    return true;
+}
 
-    // 3. リスク(Risk)のロード ★修正：引数 risk_csv を使用するように変更
-    std::ifstream rf(risk_csv);
-    if (!rf.is_open()) {
-        std::cerr << "Risk map not found, using default 0.05" << std::endl;
-    } else {
-        while (std::getline(rf, line)) {
-            if (!line.empty()) risk_map.push_back(std::stod(line));
-        }
-    }
+void SOMEvaluator::publish(std::unique_ptr<const SOMModel> next) {
+    std::lock_guard<std::mutex> lock(publish_mtx);
+    swap_in(std::move(next));
+    published.fetch_add(1, std::memory_order_release);
+}
 
-    // 4. スケーリングパラメータのロード
-    std::ifstream pf(params_csv);
-    if (!pf.is_open()) return false;
-    std::getline(pf, line); // ヘッダーをスキップ
-    while (std::getline(pf, line)) {
-        std::stringstream ss(line);
-        std::string feature_name, min_val, max_val;
-        // フォーマット: feature_name,min,max
-        if (std::getline(ss, feature_name, ',') && 
-            std::getline(ss, min_val, ',') && 
-            std::getline(ss, max_val, ',')) {
-            mins.push_back(std::stod(min_val));
-            maxs.push_back(std::stod(max_val));
-        }
+bool SOMEvaluator::publishIf(std::unique_ptr<const SOMModel> next, std::uint64_t expected,
+                             std::uint64_t expected_labels) {
+    std::lock_guard<std::mutex> lock(publish_mtx);
+    if (published.load(std::memory_order_relaxed) != expected ||
+        relabeled.load(std::memory_order_relaxed) != expected_labels) {
+        return false;
     }
+    swap_in(std::move(next));
+    published.fetch_add(1, std::memory_order_release);
+    return true;
+}
 
-    // バリデーション (7つの特徴量: imbalance, imbalance_change, btc_imbalance, btc_imbalance_change)
-    if (map_weights.size() != 400 || expectancy_map.size() != 400 || mins.size() != 7) {
+bool SOMEvaluator::relabel(const std::vector<double>& expectancy, const std::vector<double>& risk,
+                           std::uint64_t expected) {
+    std::lock_guard<std::mutex> lock(publish_mtx);
+    const SOMModel* model = current.load(std::memory_order_acquire);
+    if (!model || published.load(std::memory_order_relaxed) != expected ||
+        expectancy.size() != model->node_count || risk.size() != model->node_count) {
         return false;
     }
-    return true; 
+    auto next = std::make_unique<SOMModel>(*model);
+    next->expectancy = expectancy;
+    next->risk = risk;
+    swap_in(std::move(next));
+    relabeled.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool SOMEvaluator::snapshot(SOMModel& out, std::uint64_t& generation, std::uint64_t* label_version) {
+    // 公開側の排他の中で読むので、複製している間に差し替え・解放されることはない
+    std::lock_guard<std::mutex> lock(publish_mtx);
+    const SOMModel* model = current.load(std::memory_order_acquire);
+    if (!model) return false;
+    out = *model;
+    generation = published.load(std::memory_order_relaxed);
+    if (label_version) *label_version = relabeled.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool SOMEvaluator::snapshotLabels(std::vector<double>& expectancy, std::vector<double>& risk,
+                                  std::uint64_t& generation, std::uint64_t& label_version) {
+    std::lock_guard<std::mutex> lock(publish_mtx);
+    const SOMModel* model = current.load(std::memory_order_acquire);
+    if (!model) return false;
+    expectancy = model->expectancy;
+    risk = model->risk;
+    generation = published.load(std::memory_order_relaxed);
+    label_version = relabeled.load(std::memory_order_relaxed);
+    return true;
+}
+
+void SOMEvaluator::swap_in(std::unique_ptr<const SOMModel> next) {
+    const SOMModel* prev = current.exchange(next.release(), std::memory_order_seq_cst);
+    if (prev) retired.emplace_back(prev);
+
+    // 差し替えより後に来た読み手は新しいモデルしか見ない。
+    // ここで読み手が0なら、古いモデルを読んでいる途中の読み手はいないので全部解放できる
+    // （残っていれば次の差し替えまで持ち越す）
+    if (readers.load(std::memory_order_seq_cst) == 0) retired.clear();
+}
+
+SOMEvaluator::~SOMEvaluator() {
+    // 破棄時には推論スレッドは止まっている前提（retired は unique_ptr が解放する）
+    delete current.load(std::memory_order_acquire);
 }
 
 SOMResult SOMEvaluator::getPrediction(const std::vector<double>& raw_data) {
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    // 入力データのサイズバリデーションを追加
-    if (mins.empty() || map_weights.empty() || raw_data.size() < mins.size()) {
+    return getPrediction(raw_data.data(), raw_data.size());
+}
+
+SOMResult SOMEvaluator::getPrediction(const double* raw_data, size_t count) {
+    ReadGuard guard(*this);
+    const SOMModel* model = guard.model();
+
+    // 入力データのサイズバリデーション
+    if (!model || count != model->feature_count) {
         return {0.0, 0.05}; 
     }
-    // A. スケーリング（計算は1回だけ）
-    std::vector<double> scaled_data(raw_data.size());
-    for(size_t i=0; i < raw_data.size(); ++i) {
-        double range = maxs[i] - mins[i]; // 0の場合もある
-        scaled_data[i] = (range < 1e-9) ? 0.5 : (raw_data[i] - mins[i]) / range;
+    // A. スケーリング（スタック上。余りのレーンは0）
+    alignas(64) double scaled_data[SOMModel::MAX_FEATURES];
+    model->scale(raw_data, scaled_data);
+
+    // B. BMU探索（L1距離、AVX2 またはスカラー）
+    size_t best_idx;
+    if (search == SOMSearch::Coherent) {
+        bool hit;
+        best_idx = model->find_bmu_near(scaled_data, last_bmu.load(std::memory_order_relaxed), nullptr, hit);
+        last_bmu.store(best_idx, std::memory_order_relaxed);
+        // 書くのは推論スレッドだけなので fetch_add は要らない
+        coherent_predictions.store(coherent_predictions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (hit) coherent_hits.store(coherent_hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        best_idx = model->find_bmu(scaled_data);
     }
 
-    // B. BMU探索（爆速ループ：計算は1回だけ）
-    int best_idx = 0;
-    double min_dist = 1e18;
-    for(int i=0; i < (int)map_weights.size(); ++i) {
-        double dist = calculateDist(map_weights[i], scaled_data);
-        if(dist < min_dist) {
-            min_dist = dist;
-            best_idx = i;
+    // C. 結果をペアで返す
+    return {model->expectancy[best_idx], model->risk[best_idx]};
+}
+
+namespace {
+
+// 行 [begin, end) を BATCH_ROWS 行ずつスケーリングして find_bmus() に渡す。load_row(i, raw) が行 i を raw に読む
+template <typename LoadRow>
+void predict_rows(const SOMModel& model, size_t begin, size_t end, const SOMBatchOutput& out, LoadRow load_row) {
+    constexpr size_t BLOCK = SOMEvaluator::BATCH_ROWS;
+    alignas(64) double scaled[BLOCK * SOMModel::MAX_FEATURES];
+    double raw[SOMModel::MAX_FEATURES];
+    size_t bmu[BLOCK];
+    double dist[BLOCK];
+    for (size_t i = begin; i < end; i += BLOCK) {
+        size_t rows = std::min(BLOCK, end - i);
+        for (size_t r = 0; r < rows; ++r) {
+            load_row(i + r, raw);
+            model.scale(raw, scaled + r * model.stride);
+        }
+        model.find_bmus(scaled, rows, bmu, dist);
+        for (size_t r = 0; r < rows; ++r) {
+            if (out.bmu) out.bmu[i + r] = bmu[r];
+            if (out.expectancy) out.expectancy[i + r] = model.expectancy[bmu[r]];
+            if (out.risk) out.risk[i + r] = model.risk[bmu[r]];
+            if (out.distance) out.distance[i + r] = dist[r];
         }
     }
+}
 
-    // C. 結果をペアで返す
-    double exp = expectancy_map[best_idx];
-    double risk = (best_idx < (int)risk_map.size()) ? risk_map[best_idx] : 0.05;
+// count 行を threads 本に分ける（ブロックの境目で切る）
+template <typename LoadRow>
+void predict_parallel(const SOMModel& model, size_t count, const SOMBatchOutput& out, unsigned threads,
+                      LoadRow load_row) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t max_threads = std::max<size_t>(1, count / SOMEvaluator::BATCH_MIN_ROWS_PER_THREAD);
+    threads = static_cast<unsigned>(std::min<size_t>(threads, max_threads));
+    if (threads <= 1) {
+        predict_rows(model, 0, count, out, load_row);
+        return;
+    }
+    size_t blocks = (count + SOMEvaluator::BATCH_ROWS - 1) / SOMEvaluator::BATCH_ROWS;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t begin = std::min(count, blocks * t / threads * SOMEvaluator::BATCH_ROWS);
+        size_t end = std::min(count, blocks * (t + 1) / threads * SOMEvaluator::BATCH_ROWS);
+        workers.emplace_back([&model, &out, load_row, begin, end]() { predict_rows(model, begin, end, out, load_row); });
+    }
+    for (auto& w : workers) w.join();
+}
+
+} // namespace
 
-    return {exp, risk};
+bool SOMEvaluator::getPredictions(const double* rows, size_t count, size_t feature_count,
+                                  const SOMBatchOutput& out, unsigned threads) const {
+    ReadGuard guard(*this);
+    const SOMModel* model = guard.model();
+    bool ok = model && feature_count == model->feature_count;
+    if (ok) {
+        predict_parallel(*model, count, out, threads, [rows, feature_count](size_t i, double* raw) {
+            const double* row = rows + i * feature_count;
+            std::copy(row, row + feature_count, raw);
+        });
+    }
+    return ok;
 }
 
-double SOMEvaluator::calculateDist(const std::vector<double>& a, const std::vector<double>& b) {
-    double d = 0;
-    for(size_t i=0; i < a.size(); ++i) {
-        d += std::abs(a[i] - b[i]);
+bool SOMEvaluator::getPredictions(const double* const* columns, size_t feature_count, size_t count,
+                                  const SOMBatchOutput& out, unsigned threads) const {
+    ReadGuard guard(*this);
+    const SOMModel* model = guard.model();
+    bool ok = model && feature_count == model->feature_count;
+    if (ok) {
+        predict_parallel(*model, count, out, threads, [columns, feature_count](size_t i, double* raw) {
+            for (size_t f = 0; f < feature_count; ++f) raw[f] = columns[f][i];
+        });
     }
-    return d;
-}
\ No newline at end of file
+    return ok;
+}
+
+SOMShape SOMEvaluator::shape() const {
+    ReadGuard guard(*this);
+    const SOMModel* model = guard.model();
+    SOMShape s;
+    if (!model) return s;
+    s.grid_width = model->grid_width;
+    s.grid_height = model->grid_height;
+    s.feature_count = model->feature_count;
+    s.kernel = bmu_kernel_name(model->kernel);
+    return s;
+}
+
+SOMSearchStats SOMEvaluator::searchStats() const {
+    SOMSearchStats s;
+    s.predictions = coherent_predictions.load(std::memory_order_relaxed);
+    s.hits = coherent_hits.load(std::memory_order_relaxed);
+    return s;
+}
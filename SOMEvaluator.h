@@ -1,6 +1,12 @@
 #ifndef SOMEVALUATOR_H
 #define SOMEVALUATOR_H
 
+#include "SOMKernels.h"
+#include "SOMModel.h"
+#include "SOMOptions.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 #include <mutex>
@@ -13,16 +19,58 @@ struct SOMResult {
     double risk;       // リスク（価格変化率の標準偏差）
 };
 
+/**
+ * @brief Coherent 探索の集計（近傍だけで決着した割合）
+ */
+struct SOMSearchStats {
+    std::uint64_t predictions = 0;
+    std::uint64_t hits = 0;
+};
+
+/**
+ * @brief getPredictions() の出力先（どれも count 要素。要らないものは nullptr）
+ */
+struct SOMBatchOutput {
+    size_t* bmu = nullptr;        // BMUのノード番号
+    double* expectancy = nullptr; // 期待値
+    double* risk = nullptr;       // リスク
+    double* distance = nullptr;   // BMUまでのL1距離（スケーリング後）
+};
+
+/**
+ * @brief 公開中のモデルの形（ログ表示用）
+ */
+struct SOMShape {
+    size_t grid_width = 0;
+    size_t grid_height = 0;
+    size_t feature_count = 0;
+    const char* kernel = "none"; // BMU探索カーネルの名前（"avx2/8" など）
+};
+
 /**
  * @brief 自己組織化マップ(SOM)を用いて市場データを評価するクラス
+ * グリッドの大きさと特徴量数はモデルから読み、BMU探索はモデルの stride と CPU に合わせて選んだ
+ * カーネル（AVX2 またはスカラーの特化版・汎用版）で行う。
+ *
+ * モデルは組み立て終わってから不変のオブジェクトとして原子的なポインタの差し替えで公開する（RCU方式）。
+ * 推論側はロックを取らずに、読み手の数を1つ増やしてからポインタを読み、終わったら減らす。
+ * 差し替えられた古いモデルはすぐには消さず、差し替え時に読み手が1人もいなければまとめて解放する
+ * （そのとき読み手がいなければ、古いモデルを指している読み手はいない）。
+ * 何秒もかかりうる getPredictions() も読み手として数えるので、その間は解放を次の差し替えへ見送る。
  */
 class SOMEvaluator {
 public:
+    static constexpr size_t BATCH_ROWS = 64;            // getPredictions() のブロックの行数
+    static constexpr size_t BATCH_MIN_ROWS_PER_THREAD = 4096; // これより少なければスレッドを増やさない
+
     SOMEvaluator() = default;
-    ~SOMEvaluator() = default;
+    ~SOMEvaluator();
+    SOMEvaluator(const SOMEvaluator&) = delete;
+    SOMEvaluator& operator=(const SOMEvaluator&) = delete;
 
     /**
      * @brief 各種CSVファイルから学習済みモデルをロードする
+     * 読み込み・検証に失敗したときは今のモデルをそのまま使い続ける
      * @return ロード成功時 true
      */
     bool loadModel(const std::string& weights_csv, 
@@ -30,29 +78,124 @@ public:
                    const std::string& params_csv,
                    const std::string& risk_csv);
 
+    /**
+     * @brief 1ファイル形式のモデル（SOMModelFile.h）をロードする
+     * 壊れている・チェックサムが合わないときは今のモデルをそのまま使い続ける
+     * @return ロード成功時 true
+     */
+    bool loadModelFile(const std::string& model_path);
+
     /**
      * @brief 生データからBMU(最良一致ユニット)を特定し、期待値とリスクを返す
      * @param raw_data 特徴量ベクトル（スケーリング前）
      */
     SOMResult getPrediction(const std::vector<double>& raw_data);
 
-private:
     /**
-     * @brief ベクトル間の距離（L1ノルム/マンハッタン距離）を計算する
+     * @brief 同上（ヒープ確保なし）。raw_data はモデルの特徴量数と同じ count 個
+     */
+    SOMResult getPrediction(const double* raw_data, size_t count);
+
+    /**
+     * @brief 組み立て済みのモデルを公開する（以降の推論はこのモデルを使う）
+     */
+    void publish(std::unique_ptr<const SOMModel> next);
+
+    /**
+     * @brief 世代が expected、ラベルの版が expected_labels のまま（その後だれも公開していない）なら next を公開する
+     * 写し取ったモデルを少しずつ直して戻す側（SOMOnlineLearner）が、その間に公開された
+     * 全再学習のモデルや relabel() のラベルを古いもので上書きしないために使う
+     * @return 公開したら true（新しい世代は expected + 1）
      */
-    double calculateDist(const std::vector<double>& a, const std::vector<double>& b);
+    bool publishIf(std::unique_ptr<const SOMModel> next, std::uint64_t expected, std::uint64_t expected_labels);
+
+    /**
+     * @brief 重みはそのままで、期待値とリスクだけを差し替える（relabel_som() の結果）
+     * 公開中のモデルの写しにラベルを入れて、publish() と同じポインタの差し替えで公開する。
+     * ラベルだけを別のポインタで公開すると、差し替わった直後の別のモデルと組み合わさりうるので、重みも一緒に写す
+     * （ノード数 × stride のコピーだけで、近傍探索の下限は計算し直さない）。
+     * 重みは変わらないので世代（generation()）は進めず、ラベルの版（labelVersion()）だけを進める。
+     * オンライン学習はラベルの版が変わったのを見て、手元のモデルのラベルだけを取り込む（写し直しはしない）。
+     * @return 世代が expected のままでノード数が合えば true（その間に別のモデルが公開されていれば何もしない）
+     */
+    bool relabel(const std::vector<double>& expectancy, const std::vector<double>& risk, std::uint64_t expected);
+
+    /**
+     * @brief 公開中のモデルを out に複製し、その世代を返す（モデルが無ければ false）
+     */
+    bool snapshot(SOMModel& out, std::uint64_t& generation, std::uint64_t* label_version = nullptr);
+
+    /**
+     * @brief 公開中のモデルの期待値とリスクだけを写す（重みは写さない。モデルが無ければ false）
+     */
+    bool snapshotLabels(std::vector<double>& expectancy, std::vector<double>& risk, std::uint64_t& generation,
+                        std::uint64_t& label_version);
+
+    // publish() / publishIf() されるたびに1増える（relabel() では増えない）
+    std::uint64_t generation() const { return published.load(std::memory_order_acquire); }
+    // relabel() されるたびに1増える
+    std::uint64_t labelVersion() const { return relabeled.load(std::memory_order_acquire); }
+
+    // モデルがロード済みか
+    bool hasModel() const { return current.load(std::memory_order_acquire) != nullptr; }
+
+    /**
+     * @brief 行優先の count 行（1行 feature_count 個、スケーリング前）をまとめて推論する
+     * リプレイや研究用。行を BATCH_ROWS ずつのブロックに分けて threads 本（0 ならCPU数）で処理する。
+     * 結果は1行ずつ getPrediction() したのと同じ（Coherent 探索の状態と集計には触れない）
+     * @return モデルが無い・特徴量数が合わないときは false
+     */
+    bool getPredictions(const double* rows, size_t count, size_t feature_count,
+                        const SOMBatchOutput& out, unsigned threads = 0) const;
+
+    /**
+     * @brief 同上（列形式。columns[f] が特徴量 f の count 個）
+     */
+    bool getPredictions(const double* const* columns, size_t feature_count, size_t count,
+                        const SOMBatchOutput& out, unsigned threads = 0) const;
+
+    // 公開中のモデルの形
+    SOMShape shape() const;
+
+    // BMUの探し方（推論を始める前に設定する）
+    void setSearch(SOMSearch mode) { search = mode; }
+    SOMSearchStats searchStats() const;
+
+private:
+    // 公開中のモデル（重み・期待値・リスク・スケーリングパラメータ）。推論側はこれを読むだけ
+    std::atomic<const SOMModel*> current{nullptr};
+
+    // Coherent 探索の状態。1銘柄の推論は1スレッドから呼ばれるので書くのはそのスレッドだけ（集計は他から読む）
+    SOMSearch search = SOMSearch::Full;
+    std::atomic<size_t> last_bmu{0};
+    std::atomic<std::uint64_t> coherent_predictions{0};
+    std::atomic<std::uint64_t> coherent_hits{0};
+
+    // current を読んでから使い終わるまでの間にいる読み手の数
+    mutable std::atomic<unsigned> readers{0};
+
+    // 読み手の数を増やしてから current を読む（publish の解放と順序を揃えるため seq_cst）
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const SOMEvaluator& owner) : owner_(owner) {
+            owner_.readers.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~ReadGuard() { owner_.readers.fetch_sub(1, std::memory_order_release); }
+        const SOMModel* model() const { return owner_.current.load(std::memory_order_seq_cst); }
+
+    private:
+        const SOMEvaluator& owner_;
+    };
 
-    // モデルデータ
-    std::vector<std::vector<double>> map_weights;  // 各ノードの重みベクトル
-    std::vector<double> expectancy_map;           // 各ノードの期待値
-    std::vector<double> risk_map;                 // 各ノードのリスク（標準偏差）
-    
-    // スケーリングパラメータ
-    std::vector<double> mins; // 各特徴量の最小値
-    std::vector<double> maxs; // 各特徴量の最大値
+    // 公開側（学習スレッド）どうしの排他。推論側は取らない
+    std::mutex publish_mtx;
+    // 差し替えられたが、まだ読み手が残っているかもしれないモデル
+    std::vector<std::unique_ptr<const SOMModel>> retired;
+    std::atomic<std::uint64_t> published{0};
+    std::atomic<std::uint64_t> relabeled{0};
 
-    // スレッド安全性を確保するためのミューテックス
-    mutable std::mutex mtx;
+    // publish_mtx を取った状態で差し替える（世代・ラベルの版は呼び出し側が進める）
+    void swap_in(std::unique_ptr<const SOMModel> next);
 };
 
 #endif // SOMEVALUATOR_H
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "SOMKernels.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MM_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang は関数単位で AVX2 を有効にする（全体を -mavx2 でビルドしなくてよい）。MSVC は不要
+#if defined(MM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MM_TARGET_AVX2
+#endif
+
+namespace {
+
+inline double node_dist_scalar(const double* w, const double* x, size_t stride) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (size_t j = 0; j < stride; j += 4) {
+        s0 += std::abs(w[j] - x[j]);
+        s1 += std::abs(w[j + 1] - x[j + 1]);
+        s2 += std::abs(w[j + 2] - x[j + 2]);
+        s3 += std::abs(w[j + 3] - x[j + 3]);
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+// STRIDE が 0 なら実行時の stride を使う（汎用版）。それ以外は stride を定数に置き換えてループを展開させる
+template <size_t STRIDE>
+size_t bmu_l1_scalar_impl(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist) {
+    if (STRIDE != 0) stride = STRIDE;
+    size_t best = 0;
+    double min_dist = 1e300;
+    for (size_t n = 0; n < node_count; ++n) {
+        double d = node_dist_scalar(weights + n * stride, x, stride);
+        if (d < min_dist) {
+            min_dist = d;
+            best = n;
+        }
+    }
+    if (best_dist) *best_dist = min_dist;
+    return best;
+}
+
+} // namespace
+
+size_t bmu_l1_scalar(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist) {
+    return bmu_l1_scalar_impl<0>(weights, node_count, stride, x, best_dist);
+}
+
+#ifdef MM_X86
+
+namespace {
+
+MM_TARGET_AVX2 inline __m256d node_acc_avx2(const double* w, const __m256d* xv, size_t groups, __m256d sign) {
+    __m256d acc = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_load_pd(w), xv[0]));
+    for (size_t j = 1; j < groups; ++j) {
+        acc = _mm256_add_pd(acc, _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_load_pd(w + 4 * j), xv[j])));
+    }
+    return acc;
+}
+
+// 4ノードずつ、ノードごとの4レーンの和を hadd でまとめて4つの距離を1本のベクトルにする。
+// STRIDE の扱いはスカラー版と同じ
+template <size_t STRIDE>
+MM_TARGET_AVX2
+size_t bmu_l1_avx2_impl(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist) {
+    if (STRIDE != 0) stride = STRIDE;
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const size_t groups = stride / 4;
+    __m256d xv[16]; // stride は SOMModel::MAX_FEATURES（64）以下
+    for (size_t j = 0; j < groups; ++j) xv[j] = _mm256_loadu_pd(x + 4 * j);
+
+    size_t best = 0;
+    double min_dist = 1e300;
+    alignas(32) double d[4];
+    size_t n = 0;
+    for (; n + 4 <= node_count; n += 4) {
+        const double* w = weights + n * stride;
+        __m256d a0 = node_acc_avx2(w, xv, groups, sign);
+        __m256d a1 = node_acc_avx2(w + stride, xv, groups, sign);
+        __m256d a2 = node_acc_avx2(w + 2 * stride, xv, groups, sign);
+        __m256d a3 = node_acc_avx2(w + 3 * stride, xv, groups, sign);
+        // h01 = [a0.0+a0.1, a1.0+a1.1, a0.2+a0.3, a1.2+a1.3]
+        __m256d h01 = _mm256_hadd_pd(a0, a1);
+        __m256d h23 = _mm256_hadd_pd(a2, a3);
+        // [ (a0.0+a0.1)+(a0.2+a0.3), (a1..), (a2..), (a3..) ]
+        __m256d lo = _mm256_permute2f128_pd(h01, h23, 0x20);
+        __m256d hi = _mm256_permute2f128_pd(h01, h23, 0x31);
+        __m256d dv = _mm256_add_pd(lo, hi);
+        // 4つとも今の最小以上なら比べ直さない（ほとんどの回はここで抜ける）
+        if (_mm256_movemask_pd(_mm256_cmp_pd(dv, _mm256_set1_pd(min_dist), _CMP_LT_OQ)) == 0) continue;
+        _mm256_store_pd(d, dv);
+        for (int k = 0; k < 4; ++k) {
+            if (d[k] < min_dist) {
+                min_dist = d[k];
+                best = n + k;
+            }
+        }
+    }
+    for (; n < node_count; ++n) {
+        double dn = node_dist_scalar(weights + n * stride, x, stride);
+        if (dn < min_dist) {
+            min_dist = dn;
+            best = n;
+        }
+    }
+    if (best_dist) *best_dist = min_dist;
+    return best;
+}
+
+} // namespace
+
+size_t bmu_l1_avx2(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist) {
+    return bmu_l1_avx2_impl<0>(weights, node_count, stride, x, best_dist);
+}
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false; // OS が YMM レジスタを保存するか
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#else
+
+size_t bmu_l1_avx2(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist) {
+    return bmu_l1_scalar(weights, node_count, stride, x, best_dist);
+}
+
+bool cpu_has_avx2() { return false; }
+
+#endif
+
+namespace {
+
+struct KernelEntry {
+    size_t stride; // 0 = 汎用
+    BmuKernel kernel;
+    const char* name;
+};
+
+// 特化版は stride 4（特徴量 1〜4）、8（5〜8、本番の7特徴量）、16（13〜16）
+const KernelEntry SCALAR_KERNELS[] = {
+    {4, &bmu_l1_scalar_impl<4>, "scalar/4"},
+    {8, &bmu_l1_scalar_impl<8>, "scalar/8"},
+    {16, &bmu_l1_scalar_impl<16>, "scalar/16"},
+    {0, &bmu_l1_scalar, "scalar"},
+};
+
+#ifdef MM_X86
+const KernelEntry AVX2_KERNELS[] = {
+    {4, &bmu_l1_avx2_impl<4>, "avx2/4"},
+    {8, &bmu_l1_avx2_impl<8>, "avx2/8"},
+    {16, &bmu_l1_avx2_impl<16>, "avx2/16"},
+    {0, &bmu_l1_avx2, "avx2"},
+};
+#endif
+
+template <size_t N>
+BmuKernel find_kernel(const KernelEntry (&table)[N], size_t stride) {
+    for (const auto& e : table) {
+        if (e.stride == stride || e.stride == 0) return e.kernel;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+BmuKernel select_bmu_kernel(size_t stride) {
+#ifdef MM_X86
+    static const bool avx2 = cpu_has_avx2();
+    if (avx2) return find_kernel(AVX2_KERNELS, stride);
+#endif
+    return find_kernel(SCALAR_KERNELS, stride);
+}
+
+const char* bmu_kernel_name(BmuKernel kernel) {
+    for (const auto& e : SCALAR_KERNELS) {
+        if (e.kernel == kernel) return e.name;
+    }
+#ifdef MM_X86
+    for (const auto& e : AVX2_KERNELS) {
+        if (e.kernel == kernel) return e.name;
+    }
+#endif
+    return "unknown";
+}
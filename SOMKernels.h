@@ -0,0 +1,31 @@
+#ifndef SOMKERNELS_H
+#define SOMKERNELS_H
+
+#include <cstddef>
+
+/**
+ * BMU（最も近いノード）探索のカーネル。距離は L1（マンハッタン距離）。
+ * weights はノードごとに stride 個（4の倍数、余りは0）の double、x も stride 個。
+ * 戻り値は最も近いノードの番号（同じ距離なら番号の小さい方）で、best_dist に距離を書く。
+ *
+ * 加算の順序はどのカーネルも同じにしてある:
+ *   s_k = Σ_j |w[4j+k] - x[4j+k]|（k = 0..3、j の昇順）, dist = (s_0 + s_1) + (s_2 + s_3)
+ * なので AVX2 版とスカラー版は常に同じノードを返す。
+ */
+using BmuKernel = size_t (*)(const double* weights, size_t node_count, size_t stride,
+                             const double* x, double* best_dist);
+
+// 汎用版（stride は実行時の値）。特化版は select_bmu_kernel() から得る
+size_t bmu_l1_scalar(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist);
+
+// x86 で AVX2 が使えるときだけ呼べる
+size_t bmu_l1_avx2(const double* weights, size_t node_count, size_t stride, const double* x, double* best_dist);
+
+bool cpu_has_avx2();
+
+// 実行中のCPUで使える最速のカーネル。stride が 4 / 8 / 16 ならコンパイル時に展開した特化版、
+// それ以外は汎用版を返す（CPUの判定は初回だけ）
+BmuKernel select_bmu_kernel(size_t stride);
+const char* bmu_kernel_name(BmuKernel kernel);
+
+#endif
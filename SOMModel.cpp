@@ -0,0 +1,144 @@
+#include "SOMModel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool SOMModel::build(const std::vector<std::vector<double>>& weight_rows, size_t width, size_t height,
+                     const std::vector<double>& feature_mins, const std::vector<double>& feature_maxs,
+                     std::vector<double> expectancy_map, std::vector<double> risk_map) {
+    size_t features = feature_mins.size();
+    if (weight_rows.empty() || features == 0 || features > MAX_FEATURES || feature_maxs.size() != features ||
+        expectancy_map.size() != weight_rows.size() || width * height != weight_rows.size()) {
+        return false;
+    }
+    for (const auto& row : weight_rows) {
+        if (row.size() != features) return false;
+    }
+
+    node_count = weight_rows.size();
+    grid_width = width;
+    grid_height = height;
+    feature_count = features;
+    stride = padded_stride(features);
+
+    weights.resize(node_count * stride);
+    for (size_t n = 0; n < node_count; ++n) {
+        for (size_t f = 0; f < features; ++f) weights[n * stride + f] = weight_rows[n][f];
+    }
+
+    set_scaling(feature_mins, feature_maxs);
+
+    expectancy = std::move(expectancy_map);
+    // リスクが無い・足りないノードは従来どおり 0.05
+    risk_map.resize(node_count, 0.05);
+    risk = std::move(risk_map);
+    finalize();
+    return true;
+}
+
+namespace {
+
+// ノード p を中心とする近傍の矩形 [x0, x1] × [y0, y1]
+struct Neighborhood {
+    size_t x0, x1, y0, y1;
+};
+
+Neighborhood neighborhood(size_t p, size_t width, size_t height, size_t radius) {
+    size_t px = p % width, py = p / width;
+    return {px >= radius ? px - radius : 0, std::min(width - 1, px + radius),
+            py >= radius ? py - radius : 0, std::min(height - 1, py + radius)};
+}
+
+// 行ごとの連続したノード [start, start + count) をカーネルで探し、best を更新する（番号の昇順に呼ぶこと）
+void scan_run(BmuKernel kernel, const double* weights, size_t stride, const double* x,
+              size_t start, size_t count, size_t& best, double& best_dist) {
+    if (count == 0) return;
+    double d;
+    size_t i = kernel(weights + start * stride, count, stride, x, &d);
+    if (d < best_dist) {
+        best_dist = d;
+        best = start + i;
+    }
+}
+
+} // namespace
+
+void SOMModel::finalize() {
+    kernel = select_bmu_kernel(stride);
+
+    // 各ノードの重みを x として、近傍の外のノードをカーネルで走査する（ノード数の2乗。ロード時に1回だけ）
+    outside_min.assign(node_count, std::numeric_limits<double>::infinity());
+    if (grid_width == 0 || grid_width * grid_height != node_count) return;
+    for (size_t p = 0; p < node_count; ++p) {
+        Neighborhood nb = neighborhood(p, grid_width, grid_height, SEARCH_RADIUS);
+        const double* wp = weights.data() + p * stride;
+        size_t best = 0;
+        double d = std::numeric_limits<double>::infinity();
+        scan_run(kernel, weights.data(), stride, wp, 0, nb.y0 * grid_width, best, d);
+        for (size_t y = nb.y0; y <= nb.y1; ++y) {
+            scan_run(kernel, weights.data(), stride, wp, y * grid_width, nb.x0, best, d);
+            scan_run(kernel, weights.data(), stride, wp, y * grid_width + nb.x1 + 1, grid_width - 1 - nb.x1, best, d);
+        }
+        scan_run(kernel, weights.data(), stride, wp, (nb.y1 + 1) * grid_width,
+                 node_count - (nb.y1 + 1) * grid_width, best, d);
+        outside_min[p] = d;
+    }
+}
+
+void SOMModel::find_bmus(const double* x, size_t rows, size_t* bmu, double* best_dist) const {
+    for (size_t r = 0; r < rows; ++r) {
+        bmu[r] = 0;
+        best_dist[r] = std::numeric_limits<double>::infinity();
+    }
+    size_t tile = std::max<size_t>(LANE_GROUP, TILE_BYTES / (stride * sizeof(double)) / LANE_GROUP * LANE_GROUP);
+    // タイルは番号の昇順に進み、タイル間は厳密な < で比べるので、同じ距離なら番号の小さい方になる
+    for (size_t start = 0; start < node_count; start += tile) {
+        size_t count = std::min(tile, node_count - start);
+        for (size_t r = 0; r < rows; ++r) {
+            scan_run(kernel, weights.data(), stride, x + r * stride, start, count, bmu[r], best_dist[r]);
+        }
+    }
+}
+
+size_t SOMModel::find_bmu_near(const double* x, size_t prev, double* best_dist, bool& hit) const {
+    hit = false;
+    if (prev >= node_count || outside_min.size() != node_count) return find_bmu(x, best_dist);
+
+    // 近傍を番号の昇順（行ごと）に探す。同じ距離なら番号の小さい方になるのは全探索と同じ
+    Neighborhood nb = neighborhood(prev, grid_width, grid_height, SEARCH_RADIUS);
+    size_t best = prev;
+    double d_best = std::numeric_limits<double>::infinity();
+    for (size_t y = nb.y0; y <= nb.y1; ++y) {
+        scan_run(kernel, weights.data(), stride, x, y * grid_width + nb.x0, nb.x1 - nb.x0 + 1, best, d_best);
+    }
+    double d_prev;
+    kernel(weights.data() + prev * stride, 1, stride, x, &d_prev);
+
+    // 近傍の外はすべて outside_min - d_prev 以上離れている。丸め誤差の分だけ余裕を見て、
+    // それでも近傍の最小より遠ければ（同じ距離もありえないので）全探索と同じ答え
+    double bound = outside_min[prev] - d_prev;
+    double margin = 1e-12 * (outside_min[prev] + d_prev + d_best);
+    if (std::isinf(outside_min[prev]) || bound > d_best + margin) {
+        hit = true;
+        if (best_dist) *best_dist = d_best;
+        return best;
+    }
+    return find_bmu(x, best_dist);
+}
+
+void SOMModel::set_scaling(const std::vector<double>& feature_mins, const std::vector<double>& feature_maxs) {
+    mins = feature_mins;
+    maxs = feature_maxs;
+    inv_ranges.resize(mins.size());
+    for (size_t f = 0; f < mins.size(); ++f) {
+        double range = maxs[f] - mins[f];
+        inv_ranges[f] = (range < 1e-9) ? 0.0 : 1.0 / range;
+    }
+}
+
+void SOMModel::scale(const double* raw, double* out) const {
+    for (size_t f = 0; f < feature_count; ++f) {
+        out[f] = (inv_ranges[f] == 0.0) ? 0.5 : (raw[f] - mins[f]) * inv_ranges[f];
+    }
+    for (size_t f = feature_count; f < stride; ++f) out[f] = 0.0;
+}
@@ -0,0 +1,124 @@
+#ifndef SOMMODEL_H
+#define SOMMODEL_H
+
+#include "SOMKernels.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 64バイト境界に揃えた固定長配列（SIMD で読む重み用）
+ */
+template <typename T>
+class AlignedArray {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    AlignedArray() = default;
+    explicit AlignedArray(size_t n) { resize(n); }
+    AlignedArray(AlignedArray&&) = default;
+    AlignedArray& operator=(AlignedArray&&) = default;
+    // 複製（オンライン学習が公開中のモデルを写し取るときに使う）
+    AlignedArray(const AlignedArray& other) { *this = other; }
+    AlignedArray& operator=(const AlignedArray& other) {
+        if (this != &other) {
+            resize(other.size_);
+            for (size_t i = 0; i < size_; ++i) data_[i] = other.data_[i];
+        }
+        return *this;
+    }
+
+    // 中身は0で埋める
+    void resize(size_t n) {
+        data_.reset(n ? static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT))) : nullptr);
+        size_ = n;
+        for (size_t i = 0; i < n; ++i) data_[i] = T{};
+    }
+
+    T* data() { return data_.get(); }
+    const T* data() const { return data_.get(); }
+    size_t size() const { return size_; }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+private:
+    struct Deleter {
+        void operator()(T* p) const { ::operator delete(p, std::align_val_t(ALIGNMENT)); }
+    };
+    std::unique_ptr<T[], Deleter> data_;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief 推論用に並べ直した SOM モデル
+ * 重みはノードごとに stride 個（特徴量数を4の倍数に切り上げ、余りは0）の double を
+ * 1つの連続した領域に並べる。7特徴量なら1ノード8レーン = 64バイト = キャッシュライン1本。
+ * スケーリングは (x - min) * inv_range で、範囲が0の特徴量は inv_range = 0 として 0.5 に固定する。
+ * グリッドの幅・高さと特徴量数はモデルごとに決まり、BMU探索カーネルは stride に合わせて選ぶ。
+ *
+ * find_bmu_near() は前回のBMUのグリッド近傍（SEARCH_RADIUS）だけを探し、三角不等式で
+ * 近傍の外のノードが勝てないと分かればそこで終える（分からなければ全探索）。L1距離は距離の公理を満たすので
+ *   d(x, w_j) >= d(w_p, w_j) - d(x, w_p) >= outside_min[p] - d(x, w_p)
+ * が近傍の外のすべての j で成り立ち、これが近傍内の最小距離より大きければ全探索と同じノードになる。
+ */
+struct SOMModel {
+    static constexpr size_t LANE_GROUP = 4;    // AVX2 の double 4レーン
+    static constexpr size_t MAX_FEATURES = 64; // スタック上でスケーリングするための上限
+    static constexpr size_t SEARCH_RADIUS = 2; // find_bmu_near() が先に探す範囲（5x5ノード）
+    static constexpr size_t TILE_BYTES = 256 * 1024; // find_bmus() が1度に走査する重みの大きさ（L2に収まる）
+
+    size_t node_count = 0;
+    size_t feature_count = 0;
+    size_t stride = 0;
+    size_t grid_width = 0;            // grid_width * grid_height = node_count
+    size_t grid_height = 0;
+
+    AlignedArray<double> weights;     // node_count * stride
+    std::vector<std::string> feature_names;
+    std::vector<double> mins;
+    std::vector<double> maxs;
+    std::vector<double> inv_ranges;   // 1 / (max - min)。範囲が0なら 0
+    std::vector<double> expectancy;   // node_count
+    std::vector<double> risk;         // node_count
+    BmuKernel kernel = nullptr;       // stride に合わせて選んだBMU探索カーネル
+    std::vector<double> outside_min;  // ノード p の重みから、p の近傍の外にある重みまでの最小距離
+
+    static size_t padded_stride(size_t feature_count) {
+        return (feature_count + LANE_GROUP - 1) / LANE_GROUP * LANE_GROUP;
+    }
+
+    /**
+     * @brief 行ごとの重み・スケーリングの min/max から組み立てる（形が揃っていなければ false）
+     */
+    bool build(const std::vector<std::vector<double>>& weight_rows, size_t width, size_t height,
+               const std::vector<double>& feature_mins, const std::vector<double>& feature_maxs,
+               std::vector<double> expectancy_map, std::vector<double> risk_map);
+
+    // 重みと形が揃ったあとに、カーネルを選び近傍探索用の下限を計算する
+    void finalize();
+
+    // mins / maxs を設定して inv_ranges を計算する
+    void set_scaling(const std::vector<double>& feature_mins, const std::vector<double>& feature_maxs);
+
+    // raw（feature_count 個）をスケーリングして out（stride 個、余りは0）に書く
+    void scale(const double* raw, double* out) const;
+
+    // スケーリング済みの x（stride 個）に最も近いノードの番号
+    size_t find_bmu(const double* x, double* best_dist = nullptr) const {
+        return kernel(weights.data(), node_count, stride, x, best_dist);
+    }
+
+    /**
+     * @brief 複数の入力の BMU をまとめて探す（結果は1つずつ find_bmu() したのと同じ）
+     * x はスケーリング済みの rows 行（1行 stride 個）。重みを TILE_BYTES ごとのタイルに分け、
+     * 1つのタイルを全行に当ててから次のタイルへ進むので、大きなマップでも重みはキャッシュに載ったまま使われる
+     */
+    void find_bmus(const double* x, size_t rows, size_t* bmu, double* best_dist) const;
+
+    // find_bmu() と常に同じノードを返す。prev から探し始め、近傍で決着したら hit = true
+    size_t find_bmu_near(const double* x, size_t prev, double* best_dist, bool& hit) const;
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include "SOMModelFile.h"
+#include "MappedFile.h"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const char MAGIC[8] = {'M', 'M', 'S', 'O', 'M', '\0', '\0', '\0'};
+
+// ヘッダーはホストのバイト順のまま書く（x86/ARM のリトルエンディアン前提）
+template <typename T>
+void put(char* buf, size_t offset, T value) {
+    std::memcpy(buf + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const unsigned char* buf, size_t offset) {
+    T value;
+    std::memcpy(&value, buf + offset, sizeof(T));
+    return value;
+}
+
+std::array<std::uint32_t, 256> make_crc_table() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}
+
+// ペイロードのバイト数（並びは SOMModelFile.h 参照）
+std::uint64_t payload_size(std::uint64_t nodes, std::uint64_t features, std::uint64_t stride) {
+    return sizeof(double) * (nodes * stride + 2 * nodes + 2 * features) + SOM_MODEL_NAME_SIZE * features;
+}
+
+void append_doubles(std::string& out, const double* values, size_t n) {
+    out.append(reinterpret_cast<const char*>(values), n * sizeof(double));
+}
+
+} // namespace
+
+std::string som_model_path(const std::string& models_dir, const std::string& symbol) {
+    return models_dir + "/" + symbol + "_som.bin";
+}
+
+std::uint32_t crc32(const void* data, size_t size, std::uint32_t crc) {
+    static const std::array<std::uint32_t, 256> table = make_crc_table();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+std::uint32_t som_model_checksum(const void* header, const void* payload, size_t payload_size) {
+    const unsigned char* h = static_cast<const unsigned char*>(header);
+    std::uint32_t crc = crc32(h, 40);
+    crc = crc32(h + 44, SOM_MODEL_HEADER_SIZE - 44, crc);
+    return crc32(payload, payload_size, crc);
+}
+
+bool save_som_model(const std::string& path, const SOMModel& model, const std::string& symbol) {
+    if (model.node_count == 0 || model.grid_width * model.grid_height != model.node_count) return false;
+
+    std::string payload;
+    payload.reserve(static_cast<size_t>(payload_size(model.node_count, model.feature_count, model.stride)));
+    append_doubles(payload, model.weights.data(), model.node_count * model.stride);
+    append_doubles(payload, model.expectancy.data(), model.node_count);
+    append_doubles(payload, model.risk.data(), model.node_count);
+    append_doubles(payload, model.mins.data(), model.feature_count);
+    append_doubles(payload, model.maxs.data(), model.feature_count);
+    for (size_t f = 0; f < model.feature_count; ++f) {
+        char name[SOM_MODEL_NAME_SIZE] = {};
+        if (f < model.feature_names.size()) {
+            std::strncpy(name, model.feature_names[f].c_str(), SOM_MODEL_NAME_SIZE - 1);
+        }
+        payload.append(name, sizeof(name));
+    }
+
+    char header[SOM_MODEL_HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    put<std::uint32_t>(header, 8, SOM_MODEL_VERSION);
+    put<std::uint32_t>(header, 12, SOM_MODEL_HEADER_SIZE);
+    put<std::uint32_t>(header, 16, static_cast<std::uint32_t>(model.grid_width));
+    put<std::uint32_t>(header, 20, static_cast<std::uint32_t>(model.grid_height));
+    put<std::uint32_t>(header, 24, static_cast<std::uint32_t>(model.feature_count));
+    put<std::uint32_t>(header, 28, static_cast<std::uint32_t>(model.stride));
+    put<std::uint64_t>(header, 32, payload.size());
+    put<std::uint32_t>(header, 44, SOM_MODEL_DTYPE_F64);
+    put<std::int64_t>(header, 48, std::chrono::duration_cast<std::chrono::seconds>(
+                                      std::chrono::system_clock::now().time_since_epoch()).count());
+    std::memcpy(header + 56, symbol.data(), std::min(symbol.size(), SOM_MODEL_SYMBOL_SIZE - 1));
+    put<std::uint32_t>(header, 40, som_model_checksum(header, payload.data(), payload.size()));
+
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(header, sizeof(header));
+        file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!file) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::cerr << "Failed to replace " << path << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool load_som_model(const std::string& path, SOMModel& model) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    const unsigned char* p = file.data();
+    if (file.size() < SOM_MODEL_HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0 ||
+        get<std::uint32_t>(p, 8) != SOM_MODEL_VERSION ||
+        get<std::uint32_t>(p, 12) != SOM_MODEL_HEADER_SIZE ||
+        get<std::uint32_t>(p, 44) != SOM_MODEL_DTYPE_F64) {
+        std::cerr << "Unsupported SOM model format: " << path << std::endl;
+        return false;
+    }
+
+    std::uint64_t width = get<std::uint32_t>(p, 16);
+    std::uint64_t height = get<std::uint32_t>(p, 20);
+    std::uint64_t features = get<std::uint32_t>(p, 24);
+    std::uint64_t stride = get<std::uint32_t>(p, 28);
+    std::uint64_t nodes = width * height;
+    std::uint64_t size = get<std::uint64_t>(p, 32);
+    if (nodes == 0 || features == 0 || features > SOMModel::MAX_FEATURES ||
+        stride != SOMModel::padded_stride(features) || size != payload_size(nodes, features, stride) ||
+        size > file.size() - SOM_MODEL_HEADER_SIZE) {
+        std::cerr << "Malformed SOM model: " << path << std::endl;
+        return false;
+    }
+    const unsigned char* payload = p + SOM_MODEL_HEADER_SIZE;
+    if (som_model_checksum(p, payload, static_cast<size_t>(size)) != get<std::uint32_t>(p, 40)) {
+        std::cerr << "SOM model checksum mismatch: " << path << std::endl;
+        return false;
+    }
+
+    auto doubles = [](const unsigned char* src, size_t n) {
+        std::vector<double> v(n);
+        std::memcpy(v.data(), src, n * sizeof(double));
+        return v;
+    };
+    const unsigned char* cursor = payload;
+    SOMModel next;
+    next.node_count = static_cast<size_t>(nodes);
+    next.feature_count = static_cast<size_t>(features);
+    next.stride = static_cast<size_t>(stride);
+    next.grid_width = static_cast<size_t>(width);
+    next.grid_height = static_cast<size_t>(height);
+    next.weights.resize(next.node_count * next.stride);
+    std::memcpy(next.weights.data(), cursor, next.weights.size() * sizeof(double));
+    cursor += next.weights.size() * sizeof(double);
+    next.expectancy = doubles(cursor, next.node_count);
+    cursor += next.node_count * sizeof(double);
+    next.risk = doubles(cursor, next.node_count);
+    cursor += next.node_count * sizeof(double);
+    std::vector<double> mins = doubles(cursor, next.feature_count);
+    cursor += next.feature_count * sizeof(double);
+    std::vector<double> maxs = doubles(cursor, next.feature_count);
+    cursor += next.feature_count * sizeof(double);
+    next.set_scaling(mins, maxs);
+    next.finalize();
+    for (size_t f = 0; f < next.feature_count; ++f, cursor += SOM_MODEL_NAME_SIZE) {
+        const char* name = reinterpret_cast<const char*>(cursor);
+        next.feature_names.emplace_back(name, strnlen(name, SOM_MODEL_NAME_SIZE));
+    }
+    model = std::move(next);
+    return true;
+}
+
+bool load_som_model_csv(const std::string& weights_csv, const std::string& expectancy_csv,
+                        const std::string& params_csv, const std::string& risk_csv, SOMModel& model) {
+    std::vector<std::vector<double>> map_weights;  // 各ノードの重みベクトル
+    std::vector<double> expectancy_map;           // 各ノードの期待値
+    std::vector<double> risk_map;                 // 各ノードのリスク（標準偏差）
+    std::vector<std::string> names; // 各特徴量の名前
+    std::vector<double> mins; // 各特徴量の最小値
+    std::vector<double> maxs; // 各特徴量の最大値
+
+    std::string line, val;
+    try {
+        // 1. 重みのロード
+        std::ifstream wf(weights_csv);
+        if (!wf.is_open()) return false;
+        while (std::getline(wf, line)) {
+            std::vector<double> row;
+            std::stringstream ss(line);
+            while (std::getline(ss, val, ',')) { row.push_back(std::stod(val)); }
+            if (!row.empty()) map_weights.push_back(row);
+        }
+
+        // 2. 期待値(Expectancy)のロード
+        std::ifstream sf(expectancy_csv);
+        if (!sf.is_open()) return false;
+        while (std::getline(sf, line)) {
+            if (!line.empty()) expectancy_map.push_back(std::stod(line));
+        }
+
+        // 3. リスク(Risk)のロード
+        std::ifstream rf(risk_csv);
+        if (!rf.is_open()) {
+            std::cerr << "Risk map not found, using default 0.05" << std::endl;
+        } else {
+            while (std::getline(rf, line)) {
+                if (!line.empty()) risk_map.push_back(std::stod(line));
+            }
+        }
+
+        // 4. スケーリングパラメータのロード
+        std::ifstream pf(params_csv);
+        if (!pf.is_open()) return false;
+        std::getline(pf, line); // ヘッダーをスキップ
+        while (std::getline(pf, line)) {
+            std::stringstream ss(line);
+            std::string feature_name, min_val, max_val;
+            // フォーマット: feature_name,min,max
+            if (std::getline(ss, feature_name, ',') &&
+                std::getline(ss, min_val, ',') &&
+                std::getline(ss, max_val, ',')) {
+                names.push_back(feature_name);
+                mins.push_back(std::stod(min_val));
+                maxs.push_back(std::stod(max_val));
+            }
+        }
+    } catch (const std::exception& e) {
+        // 書きかけのファイルなどで数値が読めなかった
+        std::cerr << "Failed to parse SOM model: " << e.what() << std::endl;
+        return false;
+    }
+
+    // 推論用の連続領域に並べ直す
+    size_t nodes = map_weights.size();
+    size_t side = static_cast<size_t>(std::lround(std::sqrt(static_cast<double>(nodes))));
+    size_t width = side * side == nodes ? side : nodes;
+    size_t height = side * side == nodes ? side : 1;
+    SOMModel next;
+    if (!next.build(map_weights, width, height, mins, maxs, std::move(expectancy_map), std::move(risk_map))) {
+        return false;
+    }
+    next.feature_names = std::move(names);
+    model = std::move(next);
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef SOMMODELFILE_H
+#define SOMMODELFILE_H
+
+#include "SOMModel.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * 学習済み SOM モデル1つを1ファイルにまとめた形式（models/SYMBOL_som.bin）
+ *
+ *   [ヘッダー 128 バイト]
+ *     0  char[8]   magic "MMSOM\0\0\0"
+ *     8  uint32    version
+ *    12  uint32    header_size（128）
+ *    16  uint32    grid_width
+ *    20  uint32    grid_height
+ *    24  uint32    feature_count
+ *    28  uint32    stride（feature_count を4の倍数に切り上げ）
+ *    32  uint64    payload_size（ヘッダーより後ろのバイト数）
+ *    40  uint32    checksum（ヘッダーのこのフィールド以外とペイロードを続けた CRC-32。zlib.crc32 と同じ）
+ *    44  uint32    dtype（1 = float64）
+ *    48  int64     created_at（UNIX秒）
+ *    56  char[24]  symbol
+ *   [ペイロード]
+ *     weights     float64 × node_count × stride（余りのレーンは0。先頭が64バイト境界）
+ *     expectancy  float64 × node_count
+ *     risk        float64 × node_count
+ *     mins        float64 × feature_count
+ *     maxs        float64 × feature_count
+ *     names       char[32] × feature_count
+ *
+ * すべてリトルエンディアン。書く側は一時ファイルに書いてから rename するので、
+ * 読む側が書きかけのファイルを見ることはない。読む側はマップしてチェックサムまで確かめる。
+ * チェックサムはヘッダーも覆うので、グリッドの大きさや特徴量数が壊れていても信じて使うことはない。
+ * Python 側の読み書きは som_model.py。
+ */
+constexpr std::uint32_t SOM_MODEL_VERSION = 1;
+constexpr std::uint32_t SOM_MODEL_HEADER_SIZE = 128;
+constexpr std::uint32_t SOM_MODEL_DTYPE_F64 = 1;
+constexpr size_t SOM_MODEL_NAME_SIZE = 32;
+constexpr size_t SOM_MODEL_SYMBOL_SIZE = 24;
+
+// models_dir/SYMBOL_som.bin
+std::string som_model_path(const std::string& models_dir, const std::string& symbol);
+
+// CRC-32（IEEE 802.3、zlib.crc32 と同じ値）
+std::uint32_t crc32(const void* data, size_t size, std::uint32_t crc = 0);
+
+/**
+ * @brief ヘッダー（checksum のフィールドを除く）とペイロードの CRC-32
+ */
+std::uint32_t som_model_checksum(const void* header, const void* payload, size_t payload_size);
+
+/**
+ * @brief モデルを一時ファイルに書いてから path に置き換える
+ */
+bool save_som_model(const std::string& path, const SOMModel& model, const std::string& symbol);
+
+/**
+ * @brief ファイルをマップして検証し、model に組み立てる（壊れていれば false で model は触らない）
+ */
+bool load_som_model(const std::string& path, SOMModel& model);
+
+/**
+ * @brief 従来の4つのCSV（重み・期待値・スケーリング・リスク）から組み立てる
+ * グリッドは正方形とみなす（CSVには幅・高さが無い）
+ */
+bool load_som_model_csv(const std::string& weights_csv, const std::string& expectancy_csv,
+                        const std::string& params_csv, const std::string& risk_csv, SOMModel& model);
+
+#endif
@@ -0,0 +1,219 @@
+#include "SOMOnlineLearner.h"
+#include "SOMTrainer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SOMOnlineLearner::SOMOnlineLearner(const SymbolRegistry& registry, std::vector<SOMEvaluator>& evaluators,
+                                   SymbolId btc_id, OnlineLearningOptions options)
+    : evaluators_(evaluators), btc_id_(btc_id), options_(options),
+      symbols_(registry.size()) {
+    if (options_.horizon_rows == 0) options_.horizon_rows = 1;
+}
+
+void SOMOnlineLearner::push(const MarketRecord& record) {
+    if (!ring_.try_push(record)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SOMOnlineLearner::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void SOMOnlineLearner::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+}
+
+SOMOnlineLearner::Stats SOMOnlineLearner::stats() const {
+    Stats s;
+    s.rows = rows_.load(std::memory_order_relaxed);
+    s.labels = labels_.load(std::memory_order_relaxed);
+    s.published = published_.load(std::memory_order_relaxed);
+    s.rebased = rebased_.load(std::memory_order_relaxed);
+    s.rebuilt = rebuilt_.load(std::memory_order_relaxed);
+    s.adopted = adopted_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void SOMOnlineLearner::run() {
+    auto last_check = std::chrono::steady_clock::now();
+    while (running_.load(std::memory_order_relaxed)) {
+        size_t n = drain();
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_check >= std::chrono::seconds(1)) {
+            publish_due(now);
+            last_check = now;
+        }
+        if (n == 0) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+size_t SOMOnlineLearner::drain() {
+    size_t n = 0;
+    while (MarketRecord* record = ring_.front()) {
+        learn(*record);
+        ring_.pop();
+        ++n;
+    }
+    return n;
+}
+
+// 有限の outside_min の中央値（近傍の外が無いグリッドでは無限大 = 下限を使わないので作り直さない）
+double SOMOnlineLearner::median_bound(const SOMModel& model) {
+    std::vector<double> bounds;
+    bounds.reserve(model.outside_min.size());
+    for (double b : model.outside_min) {
+        if (std::isfinite(b)) bounds.push_back(b);
+    }
+    if (bounds.empty()) return std::numeric_limits<double>::infinity();
+    auto mid = bounds.begin() + bounds.size() / 2;
+    std::nth_element(bounds.begin(), mid, bounds.end());
+    return *mid;
+}
+
+bool SOMOnlineLearner::rebase(SymbolId id) {
+    SymbolState& st = symbols_[id];
+    auto model = std::make_unique<SOMModel>();
+    std::uint64_t generation = 0, label_version = 0;
+    if (!evaluators_[id].snapshot(*model, generation, &label_version)) return false;
+
+    st.variance.resize(model->node_count);
+    for (size_t n = 0; n < model->node_count; ++n) st.variance[n] = model->risk[n] * model->risk[n];
+    st.drift.assign(model->node_count, 0.0);
+    st.max_drift = 0.0;
+    st.bound_scale = median_bound(*model);
+    st.pending.clear();
+    st.model = std::move(model);
+    st.generation = generation;
+    st.label_version = label_version;
+    st.last_publish = std::chrono::steady_clock::now();
+    st.dirty = false;
+    rebased_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// 付け直したラベルだけを取り込む（重みは付け直しと同じ世代から直しているところなのでそのまま）
+bool SOMOnlineLearner::adopt_labels(SymbolId id) {
+    SymbolState& st = symbols_[id];
+    std::vector<double> expectancy, risk;
+    std::uint64_t generation = 0, label_version = 0;
+    if (!evaluators_[id].snapshotLabels(expectancy, risk, generation, label_version)) return false;
+    if (generation != st.generation || expectancy.size() != st.model->node_count) return rebase(id);
+
+    st.model->expectancy = std::move(expectancy);
+    st.model->risk = std::move(risk);
+    for (size_t n = 0; n < st.model->node_count; ++n) st.variance[n] = st.model->risk[n] * st.model->risk[n];
+    st.label_version = label_version;
+    adopted_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SOMOnlineLearner::learn(const MarketRecord& record) {
+    if (record.id >= symbols_.size()) return;
+    if (record.id == btc_id_) {
+        btc_imbalance_ = record.imbalance;
+        btc_imbalance_change_ = record.imbalance_change;
+        has_btc_ = true;
+    }
+    if (!has_btc_) return;
+
+    SymbolState& st = symbols_[record.id];
+    // 全再学習のモデルが公開されたら写し直す
+    if (!st.model || evaluators_[record.id].generation() != st.generation) {
+        if (!rebase(record.id)) return;
+    } else if (evaluators_[record.id].labelVersion() != st.label_version) {
+        if (!adopt_labels(record.id)) return;
+    }
+    SOMModel& model = *st.model;
+    if (model.feature_count != SOM_TRAINING_FEATURES) return;
+
+    // 1. horizon_rows 行前の行の損益が実現したので、その行の BMU のラベルを更新する
+    if (st.pending.size() >= options_.horizon_rows) {
+        Pending past = st.pending.front();
+        st.pending.pop_front();
+        double pnl = (record.price - past.price) / past.price * 1000.0;
+        if (std::isfinite(pnl)) {
+            double alpha = options_.label_alpha;
+            double delta = pnl - model.expectancy[past.bmu];
+            model.expectancy[past.bmu] += alpha * delta;
+            st.variance[past.bmu] = (1.0 - alpha) * (st.variance[past.bmu] + alpha * delta * delta);
+            model.risk[past.bmu] = std::sqrt(st.variance[past.bmu]);
+            labels_.fetch_add(1, std::memory_order_relaxed);
+            st.dirty = true;
+        }
+    }
+
+    // 2. 学習と同じ並びの特徴量で BMU を探し、近傍を引き寄せる（推論と同じ L1 の BMU に付けるのでラベルもそのノードへ）
+    const double raw[SOM_TRAINING_FEATURES] = {
+        record.imbalance, record.imbalance_change, btc_imbalance_, btc_imbalance_change_,
+        record.total_depth, record.volatility, record.btc_corr
+    };
+    if (!std::all_of(std::begin(raw), std::end(raw), [](double v) { return std::isfinite(v); })) return;
+    alignas(64) double x[SOMModel::MAX_FEATURES];
+    model.scale(raw, x);
+    size_t bmu = model.find_bmu(x);
+
+    const size_t width = model.grid_width, height = model.grid_height;
+    const double sigma = options_.sigma;
+    const size_t radius = static_cast<size_t>(std::ceil(3.0 * sigma));
+    size_t bx = bmu % width, by = bmu / width;
+    size_t x0 = bx >= radius ? bx - radius : 0, x1 = std::min(width - 1, bx + radius);
+    size_t y0 = by >= radius ? by - radius : 0, y1 = std::min(height - 1, by + radius);
+    for (size_t y = y0; y <= y1; ++y) {
+        double dy = static_cast<double>(y) - static_cast<double>(by);
+        for (size_t gx = x0; gx <= x1; ++gx) {
+            double dx = static_cast<double>(gx) - static_cast<double>(bx);
+            double step = options_.learning_rate * std::exp(-(dx * dx + dy * dy) / (2.0 * (sigma * sigma + 1e-5)));
+            size_t node = y * width + gx;
+            double* w = &model.weights[node * model.stride];
+            double moved = 0.0;
+            for (size_t f = 0; f < model.feature_count; ++f) {
+                double delta = step * (x[f] - w[f]);
+                w[f] += delta;
+                moved += std::abs(delta);
+            }
+            st.drift[node] += moved;
+            st.max_drift = std::max(st.max_drift, st.drift[node]);
+        }
+    }
+    st.pending.push_back({bmu, record.price});
+    rows_.fetch_add(1, std::memory_order_relaxed);
+    st.dirty = true;
+}
+
+void SOMOnlineLearner::publish_due(std::chrono::steady_clock::time_point now) {
+    for (SymbolId id = 0; id < symbols_.size(); ++id) {
+        SymbolState& st = symbols_[id];
+        if (!st.model || !st.dirty || now - st.last_publish < options_.publish_interval) continue;
+
+        // 下限を緩める量（最大で 2 * max_drift）が下限そのものに比べて大きくなったら作り直す（ノード数の2乗。たまにだけ）
+        if (2.0 * st.max_drift > BOUND_SLACK * st.bound_scale) {
+            st.model->finalize();
+            std::fill(st.drift.begin(), st.drift.end(), 0.0);
+            st.max_drift = 0.0;
+            st.bound_scale = median_bound(*st.model);
+            rebuilt_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // ノード p とその近傍の外の j の重みはそれぞれ drift[p]、max_drift 以下しか動いていないので、
+        // outside_min[p] - drift[p] - max_drift が今の重みでも下限になる
+        auto next = std::make_unique<SOMModel>(*st.model);
+        for (size_t p = 0; p < next->node_count; ++p) {
+            next->outside_min[p] -= st.drift[p] + st.max_drift;
+        }
+        if (evaluators_[id].publishIf(std::move(next), st.generation, st.label_version)) {
+            ++st.generation;
+            published_.fetch_add(1, std::memory_order_relaxed);
+        } else if (evaluators_[id].generation() != st.generation) {
+            // 先に全再学習が公開された。次の行で写し直す
+            st.model.reset();
+        } else {
+            // 先にラベルが付け直された。取り込んで、直した重みは次の確認（1秒後）で公開し直す
+            adopt_labels(id);
+            continue;
+        }
+        st.last_publish = now;
+        st.dirty = false;
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef SOMONLINELEARNER_H
+#define SOMONLINELEARNER_H
+
+#include "MarketRecorder.h"
+#include "SOMEvaluator.h"
+#include "SOMModel.h"
+#include "SOMOptions.h"
+#include "SpscRing.h"
+#include "SymbolRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief ライブの特徴量でSOMを少しずつ直すオンライン学習（専用スレッド1本）
+ * レコーダーが書いた1秒1行のレコード（MarketRecord）を受け取り、学習と同じ並びの特徴量を作る
+ * （BTC のインバランスはそれまでに届いた最新の BTC の行から取る）。銘柄ごとに公開中のモデルの複製を持ち、
+ *   - 1行ごとに BMU を探し、小さな学習率のガウス近傍で重みを引き寄せる
+ *   - horizon_rows 行後に実現した損益（x1000）で、その行の BMU の期待値と分散を指数移動平均で更新する
+ *   - publish_interval ごとに複製をもう1つ作って SOMEvaluator::publishIf() で公開する
+ * 公開の手間はふつうノード数に比例する。近傍探索の下限（outside_min）は作り直さず、重みが動いた量の分だけ
+ * 緩める（三角不等式でそのまま下限になる）。緩める量（最大で 2 * max_drift）が下限の中央値の
+ * BOUND_SLACK 倍を超えたら、下限が役に立たなくなる前に作り直す（ノード数の2乗。回数は Stats::rebuilt）。
+ * 全再学習が公開されたら（世代が変わったら）そのモデルを写し直し、ラベル待ちの行は捨てる。
+ * SOMEvaluator::relabel() でラベルだけが差し替わったら（ラベルの版が変わったら）、手元の重み・ラベル待ちの行・
+ * 移動量はそのままで期待値とリスクだけを取り込み、分散をリスクの2乗から始め直す。
+ * つまり付け直しのたびに窓の統計（付け直しに使った行が1つも無いノードは、付け直し前の公開中の値）が勝ち、
+ * 指数移動平均はそこから次の付け直しまで積み上がる。
+ */
+class SOMOnlineLearner {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+    static constexpr double BOUND_SLACK = 0.25; // 下限を緩めてよい量（outside_min の中央値に対する割合）
+
+    struct Stats {
+        std::uint64_t rows = 0;      // 学習に使った行
+        std::uint64_t labels = 0;    // 期待値・リスクに反映した実現損益
+        std::uint64_t published = 0; // 公開したモデル
+        std::uint64_t rebased = 0;   // 全再学習のモデルを写し直した回数
+        std::uint64_t rebuilt = 0;   // 公開のときに近傍探索の下限を作り直した回数
+        std::uint64_t adopted = 0;   // 付け直したラベルを取り込んだ回数
+        std::uint64_t dropped = 0;   // キュー満杯で捨てた行
+    };
+
+    /**
+     * @param evaluators SymbolId で引く推論器（公開先）
+     */
+    SOMOnlineLearner(const SymbolRegistry& registry, std::vector<SOMEvaluator>& evaluators, SymbolId btc_id,
+                     OnlineLearningOptions options = OnlineLearningOptions{});
+    ~SOMOnlineLearner() { stop(); }
+    SOMOnlineLearner(const SOMOnlineLearner&) = delete;
+    SOMOnlineLearner& operator=(const SOMOnlineLearner&) = delete;
+
+    // 書き手は1スレッド（MarketRecorder の書き込みスレッド）
+    void push(const MarketRecord& record);
+
+    void start();
+    void stop();
+    Stats stats() const;
+
+private:
+    struct Pending {
+        size_t bmu;
+        double price;
+    };
+    struct SymbolState {
+        std::unique_ptr<SOMModel> model;  // 公開中のモデルの複製（このスレッドだけが直す）
+        std::uint64_t generation = 0;     // 複製した / 最後に公開した世代
+        std::uint64_t label_version = 0;  // 取り込んだラベルの版（SOMEvaluator::labelVersion()）
+        std::vector<double> variance;     // ノードごとの損益の分散（risk の2乗から始める）
+        std::vector<double> drift;        // model の outside_min を計算してからの重みの移動量（L1）
+        double max_drift = 0.0;
+        double bound_scale = 0.0;         // model の outside_min の中央値（緩めてよい量の基準）
+        std::deque<Pending> pending;      // ラベル待ちの行
+        std::chrono::steady_clock::time_point last_publish;
+        bool dirty = false;
+    };
+
+    void run();
+    size_t drain();
+    void learn(const MarketRecord& record);
+    bool rebase(SymbolId id);
+    bool adopt_labels(SymbolId id);
+    void publish_due(std::chrono::steady_clock::time_point now);
+    static double median_bound(const SOMModel& model);
+
+    std::vector<SOMEvaluator>& evaluators_;
+    SymbolId btc_id_;
+    OnlineLearningOptions options_;
+    SpscRing<MarketRecord, QUEUE_CAPACITY> ring_;
+    std::vector<SymbolState> symbols_; // SymbolId で引く（学習スレッド専用）
+    double btc_imbalance_ = 0.0;
+    double btc_imbalance_change_ = 0.0;
+    bool has_btc_ = false;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::atomic<std::uint64_t> rows_{0};
+    std::atomic<std::uint64_t> labels_{0};
+    std::atomic<std::uint64_t> published_{0};
+    std::atomic<std::uint64_t> rebased_{0};
+    std::atomic<std::uint64_t> rebuilt_{0};
+    std::atomic<std::uint64_t> adopted_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SOMOPTIONS_H
+#define SOMOPTIONS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief BMUの探し方
+ * Full は毎回全ノード、Coherent は前回のBMUの近傍から探す（結果は常に Full と同じ。SOMModel::find_bmu_near 参照）
+ */
+enum class SOMSearch { Full, Coherent };
+
+/**
+ * @brief SOMの学習方法
+ * Native はプロセス内（SOMTrainer.h）、Python は従来どおり train_som.py を呼ぶ
+ */
+enum class TrainerKind { Native, Python };
+
+enum class SOMTrainingMode {
+    Online, // 1行ずつ更新する（train_som.py と同じ）
+    Batch   // エポックごとにまとめて更新する（並列）
+};
+
+/**
+ * @brief プロセス内の学習（SOMTrainer.h）の設定
+ */
+struct SOMTrainingOptions {
+    size_t grid_width = 20;
+    size_t grid_height = 20;
+    int epochs = 20;
+    double learning_rate = 0.03; // 最初のエポックの学習率（最後に向けて線形に0へ。Batch では使わない）
+    double sigma = 3.0;          // 最初のエポックの近傍半径（同上）
+    size_t train_rows = 30000;   // 学習に使う最新の行数
+    size_t future_rows = 30;     // 何行先の価格で損益を見るか
+    size_t min_rows = 500;       // 結合後にこれより少なければ学習しない
+    std::uint64_t seed = 0;      // 重みの初期化に使う乱数の種（0 なら毎回変える）
+    SOMTrainingMode mode = SOMTrainingMode::Online;
+
+    // 公開中のモデルから始める（そのモデルを train_som() に渡す）ときのスケジュール
+    bool warm_start = false;
+    int warm_epochs = 3;
+    double warm_learning_rate = 0.03;
+    double warm_sigma = 0.5;
+
+    // エポックごとの量子化誤差を測る（全行の BMU をもう一度探すので、その分だけ遅くなる）
+    bool track_error = false;
+};
+
+/**
+ * @brief ライブの特徴量で行うオンライン学習（SOMOnlineLearner.h）の設定
+ */
+struct OnlineLearningOptions {
+    double learning_rate = 0.002;  // 1行あたりの学習率（全再学習の最終エポック付近と同じくらい小さく）
+    double sigma = 1.0;            // 近傍半径（グリッド上）
+    size_t horizon_rows = 30;      // 何行先の価格で損益を見るか（学習の future_rows と同じ）
+    double label_alpha = 0.01;     // 期待値・分散の指数移動平均の重み
+    std::chrono::seconds publish_interval{60}; // 直したモデルを公開する間隔
+};
+
+#endif // SOMOPTIONS_H
@@ -0,0 +1,487 @@
+#include "SOMTrainer.h"
+#include "MarketDataStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+
+const std::array<const char*, SOM_TRAINING_FEATURES> SOM_FEATURE_NAMES = {
+    "imbalance", "imbalance_change", "btc_imbalance", "btc_imbalance_change",
+    "total_depth", "volatility", "btc_pearson"
+};
+
+namespace {
+
+// FeatureRow の列（FEATURE_COLUMNS の並び）
+constexpr size_t COL_TIMESTAMP = 0;
+constexpr size_t COL_IMBALANCE = 1;
+constexpr size_t COL_IMBALANCE_CHANGE = 2;
+constexpr size_t COL_TOTAL_DEPTH = 3;
+constexpr size_t COL_PRICE = 4;
+constexpr size_t COL_VOLATILITY = 6;
+constexpr size_t COL_BTC_CORR = 7;
+
+// 何行ずつワーカーに渡すか（BMUの付け直し・バッチSOMのBMU探索・量子化誤差）
+constexpr size_t LABEL_GRAIN = 2048;
+constexpr size_t BATCH_GRAIN = 4096;
+// 付け直しで何行ずつワーカーに渡すか / find_bmus() に1度に渡す行数
+constexpr size_t RELABEL_GRAIN = 4096;
+constexpr size_t RELABEL_BLOCK = 64;
+// バッチSOMの重みの置き換えで、何ノードずつワーカーに渡すか
+constexpr size_t NODE_GRAIN = 16;
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 二乗ユークリッド距離で最も近いノード（同じ距離なら番号の小さい方。numpy.argmin と同じ）
+size_t nearest_node(const double* weights, size_t nodes, size_t stride, const double* x) {
+    size_t best = 0;
+    double best_dist = std::numeric_limits<double>::infinity();
+    for (size_t n = 0; n < nodes; ++n) {
+        const double* w = weights + n * stride;
+        double d = 0.0;
+        for (size_t f = 0; f < stride; ++f) {
+            double diff = w[f] - x[f];
+            d += diff * diff;
+        }
+        if (d < best_dist) {
+            best_dist = d;
+            best = n;
+        }
+    }
+    return best;
+}
+
+// グリッド上の二乗距離 d2 ごとの factor * exp(-d2 / (2 * (sigma^2 + 1e-5)))（train_som.py の influence）。
+// 値が0にならない最大の d2 を返す（それより遠いノードは更新しても変わらないので触らない）
+size_t fill_influence(double factor, double sigma, std::vector<double>& table) {
+    size_t reach = 0;
+    for (size_t d2 = 0; d2 < table.size(); ++d2) {
+        table[d2] = factor * std::exp(-static_cast<double>(d2) / (2.0 * (sigma * sigma + 1e-5)));
+        if (table[d2] != 0.0) reach = d2;
+    }
+    return reach;
+}
+
+// reach 以内に収まるグリッド上の半径（整数）
+size_t grid_radius(size_t reach) {
+    size_t radius = static_cast<size_t>(std::sqrt(static_cast<double>(reach)));
+    while ((radius + 1) * (radius + 1) <= reach) ++radius;
+    return radius;
+}
+
+// 各行から BMU までのユークリッド距離の平均（ワーカーごとに足してから合わせる）
+double quantization_error(const double* scaled, size_t rows, size_t stride, size_t nodes,
+                          const AlignedArray<double>& weights, WorkerPool& pool) {
+    std::vector<double> partial(pool.slots(), 0.0);
+    pool.parallel_for(rows, LABEL_GRAIN, [&](size_t begin, size_t end, size_t slot) {
+        double sum = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            const double* x = scaled + i * stride;
+            const double* w = weights.data() + nearest_node(weights.data(), nodes, stride, x) * stride;
+            double d = 0.0;
+            for (size_t f = 0; f < stride; ++f) d += (w[f] - x[f]) * (w[f] - x[f]);
+            sum += std::sqrt(d);
+        }
+        partial[slot] += sum;
+    });
+    return std::accumulate(partial.begin(), partial.end(), 0.0) / static_cast<double>(rows);
+}
+
+// 1行ずつ BMU を探して近傍を引き寄せる（train_som.py と同じ。行の順に依存するので1スレッド）
+// 影響度は BMU とのグリッド上の二乗距離（整数）だけで決まるので、エポックごとに表にしておく
+void train_online(const double* scaled, size_t rows, size_t stride, size_t width, size_t height,
+                  const SOMTrainingOptions& options, WorkerPool& pool, AlignedArray<double>& weights,
+                  std::vector<double>* errors) {
+    const size_t nodes = width * height;
+    std::vector<double> step((width - 1) * (width - 1) + (height - 1) * (height - 1) + 1);
+    for (int epoch = 0; epoch < options.epochs; ++epoch) {
+        double progress = static_cast<double>(epoch) / options.epochs;
+        double learning_rate = options.learning_rate * (1.0 - progress);
+        double sigma = options.sigma * (1.0 - progress);
+        size_t reach = fill_influence(learning_rate, sigma, step);
+        size_t radius = grid_radius(reach);
+
+        for (size_t i = 0; i < rows; ++i) {
+            const double* x = scaled + i * stride;
+            size_t bmu = nearest_node(weights.data(), nodes, stride, x);
+            size_t bx = bmu % width, by = bmu / width;
+            size_t x0 = bx >= radius ? bx - radius : 0, x1 = std::min(width - 1, bx + radius);
+            size_t y0 = by >= radius ? by - radius : 0, y1 = std::min(height - 1, by + radius);
+            for (size_t y = y0; y <= y1; ++y) {
+                size_t dy = y > by ? y - by : by - y;
+                for (size_t gx = x0; gx <= x1; ++gx) {
+                    size_t dx = gx > bx ? gx - bx : bx - gx;
+                    size_t d2 = dx * dx + dy * dy;
+                    if (d2 > reach) continue;
+                    double s = step[d2];
+                    double* w = &weights[(y * width + gx) * stride];
+                    for (size_t f = 0; f < stride; ++f) w[f] += s * (x[f] - w[f]);
+                }
+            }
+        }
+        if (errors) errors->push_back(quantization_error(scaled, rows, stride, nodes, weights, pool));
+    }
+}
+
+// バッチSOM。エポックごとに
+//   1. 全行の BMU を並列に探し、スレッドごとのバッファにノードごとの行の和と行数を積む
+//   2. バッファを足し合わせる
+//   3. 各ノードの重みを、近傍のノードに集まった行の影響度つき平均にまとめて置き換える
+//      w_k = Σ_j h(k, j) S_j / Σ_j h(k, j) N_j（S_j, N_j はノード j を BMU とする行の和と数）
+// 近傍に行が1つも無いノードは前の重みのまま。近傍半径の減り方は train_online() と同じで、学習率は使わない
+void train_batch(const double* scaled, size_t rows, size_t stride, size_t width, size_t height,
+                 const SOMTrainingOptions& options, WorkerPool& pool, AlignedArray<double>& weights,
+                 std::vector<double>* errors) {
+    const size_t nodes = width * height;
+    const size_t slots = pool.slots();
+    std::vector<std::vector<double>> sums(slots, std::vector<double>(nodes * stride));
+    std::vector<std::vector<double>> counts(slots, std::vector<double>(nodes));
+    std::vector<double> influence((width - 1) * (width - 1) + (height - 1) * (height - 1) + 1);
+    AlignedArray<double> next(nodes * stride);
+
+    for (int epoch = 0; epoch < options.epochs; ++epoch) {
+        double progress = static_cast<double>(epoch) / options.epochs;
+        double sigma = options.sigma * (1.0 - progress);
+        size_t reach = fill_influence(1.0, sigma, influence);
+        size_t radius = grid_radius(reach);
+
+        for (size_t t = 0; t < slots; ++t) {
+            std::fill(sums[t].begin(), sums[t].end(), 0.0);
+            std::fill(counts[t].begin(), counts[t].end(), 0.0);
+        }
+        pool.parallel_for(rows, BATCH_GRAIN, [&](size_t begin, size_t end, size_t slot) {
+            double* sum = sums[slot].data();
+            double* count = counts[slot].data();
+            for (size_t i = begin; i < end; ++i) {
+                const double* x = scaled + i * stride;
+                size_t bmu = nearest_node(weights.data(), nodes, stride, x);
+                for (size_t f = 0; f < stride; ++f) sum[bmu * stride + f] += x[f];
+                count[bmu] += 1.0;
+            }
+        });
+        for (size_t t = 1; t < slots; ++t) {
+            for (size_t k = 0; k < nodes * stride; ++k) sums[0][k] += sums[t][k];
+            for (size_t k = 0; k < nodes; ++k) counts[0][k] += counts[t][k];
+        }
+
+        const std::vector<double>& sum = sums[0];
+        const std::vector<double>& count = counts[0];
+        pool.parallel_for(nodes, NODE_GRAIN, [&](size_t begin, size_t end, size_t) {
+            double num[SOMModel::MAX_FEATURES];
+            for (size_t k = begin; k < end; ++k) {
+                size_t kx = k % width, ky = k / width;
+                size_t x0 = kx >= radius ? kx - radius : 0, x1 = std::min(width - 1, kx + radius);
+                size_t y0 = ky >= radius ? ky - radius : 0, y1 = std::min(height - 1, ky + radius);
+                std::fill_n(num, stride, 0.0);
+                double den = 0.0;
+                for (size_t y = y0; y <= y1; ++y) {
+                    size_t dy = y > ky ? y - ky : ky - y;
+                    for (size_t gx = x0; gx <= x1; ++gx) {
+                        size_t j = y * width + gx;
+                        size_t dx = gx > kx ? gx - kx : kx - gx;
+                        size_t d2 = dx * dx + dy * dy;
+                        if (d2 > reach || count[j] == 0.0) continue;
+                        double h = influence[d2];
+                        for (size_t f = 0; f < stride; ++f) num[f] += h * sum[j * stride + f];
+                        den += h * count[j];
+                    }
+                }
+                double* w = &next[k * stride];
+                if (den > 0.0) {
+                    for (size_t f = 0; f < stride; ++f) w[f] = num[f] / den;
+                } else {
+                    std::copy_n(&weights[k * stride], stride, w);
+                }
+            }
+        });
+        std::swap(weights, next);
+        if (errors) errors->push_back(quantization_error(scaled, rows, stride, nodes, weights, pool));
+    }
+}
+
+} // namespace
+
+bool load_training_set(const std::string& data_dir, const std::string& symbol, const std::string& btc_symbol,
+                       const SOMTrainingOptions& options, SOMTrainingSet& out) {
+    std::vector<FeatureRow> target;
+    if (!read_market_tail(data_dir, symbol, options.train_rows + options.future_rows + 60, target) ||
+        target.empty()) {
+        std::cerr << "No feature data for " << symbol << std::endl;
+        return false;
+    }
+    auto by_time = [](const FeatureRow& a, const FeatureRow& b) { return a[COL_TIMESTAMP] < b[COL_TIMESTAMP]; };
+    std::stable_sort(target.begin(), target.end(), by_time);
+
+    std::vector<FeatureRow> btc;
+    auto t0 = static_cast<std::int64_t>(std::floor(target.front()[COL_TIMESTAMP])) - 60;
+    auto t1 = static_cast<std::int64_t>(std::ceil(target.back()[COL_TIMESTAMP]));
+    if (!read_market_range(data_dir, btc_symbol, t0, t1, btc)) return false;
+    std::stable_sort(btc.begin(), btc.end(), by_time);
+
+    // 各行に、その時刻以前で最も新しい BTC の行を結合する（無ければ捨てる）
+    struct Joined {
+        const FeatureRow* row;
+        const FeatureRow* btc;
+    };
+    std::vector<Joined> joined;
+    joined.reserve(target.size());
+    for (const auto& row : target) {
+        auto it = std::upper_bound(btc.begin(), btc.end(), row,
+                                   [](const FeatureRow& a, const FeatureRow& b) {
+                                       return a[COL_TIMESTAMP] < b[COL_TIMESTAMP];
+                                   });
+        if (it == btc.begin()) continue;
+        joined.push_back({&row, &*(it - 1)});
+    }
+
+    // future_rows 行先の価格との変化率。先の無い行・値が有限でない行は捨てる
+    SOMTrainingSet set;
+    set.feature_count = SOM_TRAINING_FEATURES;
+    for (size_t i = 0; i + options.future_rows < joined.size(); ++i) {
+        const FeatureRow& r = *joined[i].row;
+        const FeatureRow& b = *joined[i].btc;
+        double price = r[COL_PRICE];
+        double future_pnl = ((*joined[i + options.future_rows].row)[COL_PRICE] - price) / price;
+        const double features[SOM_TRAINING_FEATURES] = {
+            r[COL_IMBALANCE], r[COL_IMBALANCE_CHANGE], b[COL_IMBALANCE], b[COL_IMBALANCE_CHANGE],
+            r[COL_TOTAL_DEPTH], r[COL_VOLATILITY], r[COL_BTC_CORR]
+        };
+        if (!std::isfinite(future_pnl) ||
+            !std::all_of(std::begin(features), std::end(features), [](double v) { return std::isfinite(v); })) {
+            continue;
+        }
+        set.features.insert(set.features.end(), std::begin(features), std::end(features));
+        set.labels.push_back(future_pnl * 1000.0);
+    }
+
+    if (set.rows() < options.min_rows) {
+        std::cerr << "Not enough training rows for " << symbol << ": " << set.rows() << "/"
+                  << options.min_rows << std::endl;
+        return false;
+    }
+    // 最新の train_rows 行だけを使う
+    if (set.rows() > options.train_rows) {
+        size_t drop = set.rows() - options.train_rows;
+        set.features.erase(set.features.begin(), set.features.begin() + drop * set.feature_count);
+        set.labels.erase(set.labels.begin(), set.labels.begin() + drop);
+    }
+    out = std::move(set);
+    return true;
+}
+
+bool train_som(const SOMTrainingSet& data, const SOMTrainingOptions& options, WorkerPool& pool,
+               SOMModel& out, SOMTrainingReport* report, const SOMModel* initial) {
+    const size_t rows = data.rows();
+    const size_t features = data.feature_count;
+    const bool warm = options.warm_start && initial && initial->feature_count == features &&
+                      initial->node_count > 0 && initial->grid_width * initial->grid_height == initial->node_count;
+    if (options.warm_start && !warm) {
+        std::cerr << "SOM warm start skipped: no compatible model, initializing from data" << std::endl;
+    }
+    const size_t width = warm ? initial->grid_width : options.grid_width;
+    const size_t height = warm ? initial->grid_height : options.grid_height;
+    const size_t nodes = width * height;
+    if (rows == 0 || features == 0 || features > SOMModel::MAX_FEATURES || nodes == 0 ||
+        data.features.size() != rows * features) {
+        return false;
+    }
+    const size_t stride = SOMModel::padded_stride(features);
+
+    // 1. min-max スケーリング（範囲が0の特徴量は MinMaxScaler と同じく 0 になる）
+    std::vector<double> mins(features, std::numeric_limits<double>::infinity());
+    std::vector<double> maxs(features, -std::numeric_limits<double>::infinity());
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t f = 0; f < features; ++f) {
+            double v = data.features[i * features + f];
+            mins[f] = std::min(mins[f], v);
+            maxs[f] = std::max(maxs[f], v);
+        }
+    }
+    AlignedArray<double> scaled(rows * stride);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t f = 0; f < features; ++f) {
+            double range = maxs[f] - mins[f];
+            double scale = range == 0.0 ? 1.0 : 1.0 / range;
+            scaled[i * stride + f] = (data.features[i * features + f] - mins[f]) * scale;
+        }
+    }
+
+    // 2. 重みの初期値
+    AlignedArray<double> weights(nodes * stride);
+    SOMTrainingOptions schedule = options;
+    if (warm) {
+        // 前のモデルの重みを元の値に戻し、今回の min/max でスケーリングし直す
+        // （前のモデルで範囲が0だった特徴量は、その値 = min として戻す）
+        for (size_t k = 0; k < nodes; ++k) {
+            for (size_t f = 0; f < features; ++f) {
+                double old_range = initial->maxs[f] - initial->mins[f];
+                double raw = initial->mins[f] + initial->weights[k * initial->stride + f] * old_range;
+                double range = maxs[f] - mins[f];
+                weights[k * stride + f] = (raw - mins[f]) * (range == 0.0 ? 1.0 : 1.0 / range);
+            }
+        }
+        schedule.epochs = options.warm_epochs;
+        schedule.learning_rate = options.warm_learning_rate;
+        schedule.sigma = options.warm_sigma;
+    } else {
+        // データの行からランダムに選ぶ（足りなければ重複を許す）
+        std::mt19937_64 rng(options.seed ? options.seed : std::random_device{}());
+        std::vector<size_t> picks(nodes);
+        if (rows >= nodes) {
+            std::vector<size_t> order(rows);
+            std::iota(order.begin(), order.end(), size_t{0});
+            for (size_t k = 0; k < nodes; ++k) {
+                std::uniform_int_distribution<size_t> pick(k, rows - 1);
+                std::swap(order[k], order[pick(rng)]);
+                picks[k] = order[k];
+            }
+        } else {
+            std::uniform_int_distribution<size_t> pick(0, rows - 1);
+            for (auto& p : picks) p = pick(rng);
+        }
+        for (size_t k = 0; k < nodes; ++k) {
+            std::copy_n(&scaled[picks[k] * stride], stride, &weights[k * stride]);
+        }
+    }
+
+    // 3. 重みの更新
+    std::vector<double> errors;
+    std::vector<double>* track = options.track_error ? &errors : nullptr;
+    if (track) errors.push_back(quantization_error(scaled.data(), rows, stride, nodes, weights, pool));
+    auto t_train = std::chrono::steady_clock::now();
+    if (schedule.mode == SOMTrainingMode::Batch) {
+        train_batch(scaled.data(), rows, stride, width, height, schedule, pool, weights, track);
+    } else {
+        train_online(scaled.data(), rows, stride, width, height, schedule, pool, weights, track);
+    }
+    double train_seconds = seconds_since(t_train);
+
+    // 4. 全行の BMU を付け直し、ノードごとの平均と標準偏差（母標準偏差）を出す
+    auto t_label = std::chrono::steady_clock::now();
+    std::vector<size_t> winners(rows);
+    pool.parallel_for(rows, LABEL_GRAIN, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            winners[i] = nearest_node(weights.data(), nodes, stride, &scaled[i * stride]);
+        }
+    });
+    std::vector<size_t> counts(nodes, 0);
+    std::vector<double> expectancy(nodes, 0.0), risk(nodes, 0.05);
+    for (size_t i = 0; i < rows; ++i) {
+        ++counts[winners[i]];
+        expectancy[winners[i]] += data.labels[i];
+    }
+    for (size_t n = 0; n < nodes; ++n) {
+        if (counts[n]) expectancy[n] /= static_cast<double>(counts[n]);
+    }
+    std::vector<double> squares(nodes, 0.0);
+    for (size_t i = 0; i < rows; ++i) {
+        double d = data.labels[i] - expectancy[winners[i]];
+        squares[winners[i]] += d * d;
+    }
+    for (size_t n = 0; n < nodes; ++n) {
+        if (counts[n] > 1) risk[n] = std::sqrt(squares[n] / static_cast<double>(counts[n]));
+    }
+    double label_seconds = seconds_since(t_label);
+
+    // 5. 推論用のモデル（重みはすでに stride 詰めなのでそのまま渡す）
+    SOMModel next;
+    next.node_count = nodes;
+    next.feature_count = features;
+    next.stride = stride;
+    next.grid_width = width;
+    next.grid_height = height;
+    next.weights = std::move(weights);
+    next.expectancy = std::move(expectancy);
+    next.risk = std::move(risk);
+    next.set_scaling(mins, maxs);
+    next.finalize();
+    for (size_t f = 0; f < features; ++f) {
+        next.feature_names.push_back(f < SOM_FEATURE_NAMES.size() ? SOM_FEATURE_NAMES[f] : "f" + std::to_string(f));
+    }
+    out = std::move(next);
+
+    if (report) {
+        report->rows = rows;
+        report->train_seconds = train_seconds;
+        report->label_seconds = label_seconds;
+        report->warm_started = warm;
+        report->quantization_error = std::move(errors);
+    }
+    return true;
+}
+
+bool relabel_som(const SOMTrainingSet& data, const SOMModel& model, WorkerPool& pool,
+                 std::vector<double>& expectancy, std::vector<double>& risk, SOMRelabelReport* report) {
+    const size_t rows = data.rows();
+    const size_t nodes = model.node_count;
+    if (rows == 0 || nodes == 0 || data.feature_count != model.feature_count ||
+        data.features.size() != rows * data.feature_count) {
+        return false;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+
+    // ノードごとの行数・平均・平均からの偏差の二乗和（Welford 法）
+    struct Moments {
+        double count = 0.0;
+        double mean = 0.0;
+        double m2 = 0.0;
+    };
+    std::vector<std::vector<Moments>> partial(pool.slots(), std::vector<Moments>(nodes));
+    pool.parallel_for(rows, RELABEL_GRAIN, [&](size_t begin, size_t end, size_t slot) {
+        std::vector<Moments>& acc = partial[slot];
+        AlignedArray<double> x(RELABEL_BLOCK * model.stride);
+        size_t bmu[RELABEL_BLOCK];
+        double dist[RELABEL_BLOCK];
+        for (size_t start = begin; start < end; start += RELABEL_BLOCK) {
+            size_t n = std::min(RELABEL_BLOCK, end - start);
+            for (size_t r = 0; r < n; ++r) {
+                model.scale(&data.features[(start + r) * data.feature_count], &x[r * model.stride]);
+            }
+            model.find_bmus(x.data(), n, bmu, dist);
+            for (size_t r = 0; r < n; ++r) {
+                Moments& m = acc[bmu[r]];
+                double y = data.labels[start + r];
+                m.count += 1.0;
+                double delta = y - m.mean;
+                m.mean += delta / m.count;
+                m.m2 += delta * (y - m.mean);
+            }
+        }
+    });
+    // ワーカーごとの結果を合わせる（Chan らの並列版の式）
+    std::vector<Moments>& total = partial[0];
+    for (size_t t = 1; t < partial.size(); ++t) {
+        for (size_t k = 0; k < nodes; ++k) {
+            const Moments& b = partial[t][k];
+            if (b.count == 0.0) continue;
+            Moments& a = total[k];
+            double count = a.count + b.count;
+            double delta = b.mean - a.mean;
+            a.mean += delta * b.count / count;
+            a.m2 += b.m2 + delta * delta * a.count * b.count / count;
+            a.count = count;
+        }
+    }
+
+    expectancy = model.expectancy;
+    risk = model.risk;
+    size_t updated = 0;
+    for (size_t k = 0; k < nodes; ++k) {
+        const Moments& m = total[k];
+        if (m.count == 0.0) continue;
+        expectancy[k] = m.mean;
+        risk[k] = m.count > 1.0 ? std::sqrt(m.m2 / m.count) : 0.05;
+        ++updated;
+    }
+    if (report) {
+        report->rows = rows;
+        report->nodes = updated;
+        report->seconds = seconds_since(t0);
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef SOMTRAINER_H
+#define SOMTRAINER_H
+
+#include "SOMModel.h"
+#include "SOMOptions.h"
+#include "WorkerPool.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * SOM の学習（train_som.py と同じ手順をプロセス内で行う）
+ *
+ *   1. 対象銘柄の最新 train_rows + future_rows + 60 行と、その時間帯の BTC の行を features.bin から読む
+ *   2. 各行に、その時刻以前で最も新しい BTC の行を結合する（pandas.merge_asof の backward）
+ *   3. future_rows 行先の価格で future_pnl を作り、最新 train_rows 行を使う（ラベルは future_pnl * 1000）
+ *   4. 特徴量を min-max で [0, 1] にする（範囲が0の特徴量は sklearn と同じく 0）
+ *   5. データからランダムに選んだ行で重みを初期化し、エポックごとに学習率と近傍半径を線形に減らしながら
+ *      1行ずつ BMU（二乗ユークリッド距離）を探してガウス近傍で重みを更新する
+ *   6. 全行の BMU からノードごとの期待値（平均）とリスク（標準偏差）を計算する
+ *
+ * 1行ずつの更新は順番に依存するので1スレッドで行い、BMU の付け直し（6）はワーカープールで分ける。
+ * 複数銘柄は WorkerPool::parallel_for で並行に学習できる。
+ *
+ * SOMTrainingMode::Batch は5をバッチSOMに置き換える。エポックごとに全行の BMU を並列に探して
+ * ノードごとの行の和と数をスレッドごとに積み、近傍の影響度つき平均で全ノードの重みを一度に置き換える。
+ * 行の順に依存しないのでコア数にほぼ比例して速くなり、数日分（数百万行）の窓でも学習できる。
+ *
+ * warm_start のときは、train_som() に渡した公開中のモデルの重みから始める（2を置き換える）。
+ * 重みはいったん元の値に戻してから今回のデータの min/max でスケーリングし直し、グリッドの形もそのモデルに合わせる。
+ * マップはすでに整列しているので、近傍半径の小さい短いスケジュール（warm_*）で微調整だけを行い、
+ * ノードの番号（グリッド上の位置）の意味は再学習の前後で変わらない。
+ */
+
+// 学習に使う特徴量（train_som.py の features と同じ並び。推論側の features もこの順）
+constexpr size_t SOM_TRAINING_FEATURES = 7;
+extern const std::array<const char*, SOM_TRAINING_FEATURES> SOM_FEATURE_NAMES;
+
+/**
+ * @brief 学習データ（スケーリング前）
+ */
+struct SOMTrainingSet {
+    size_t feature_count = SOM_TRAINING_FEATURES;
+    std::vector<double> features; // 行優先（1行 feature_count 個）
+    std::vector<double> labels;   // future_pnl * 1000
+
+    size_t rows() const { return labels.size(); }
+};
+
+struct SOMTrainingReport {
+    size_t rows = 0;
+    double train_seconds = 0.0; // 重みの更新
+    double label_seconds = 0.0; // 期待値・リスクの計算
+    bool warm_started = false;
+    // track_error のとき、学習前と各エポック後の量子化誤差（各行から BMU までのユークリッド距離の平均）
+    std::vector<double> quantization_error;
+};
+
+struct SOMRelabelReport {
+    size_t rows = 0;
+    size_t nodes = 0;   // 行が1つ以上あって付け直したノード
+    double seconds = 0.0;
+};
+
+/**
+ * @brief data_dir から symbol の学習データを作る（行が足りなければ false）
+ */
+bool load_training_set(const std::string& data_dir, const std::string& symbol, const std::string& btc_symbol,
+                       const SOMTrainingOptions& options, SOMTrainingSet& out);
+
+/**
+ * @brief 学習して推論用のモデルを組み立てる（SOMEvaluator::publish() にそのまま渡せる）
+ * @param initial options.warm_start のときに重みを引き継ぐモデル（特徴量数が違えば使わずにデータから初期化する）
+ */
+bool train_som(const SOMTrainingSet& data, const SOMTrainingOptions& options, WorkerPool& pool,
+               SOMModel& out, SOMTrainingReport* report = nullptr, const SOMModel* initial = nullptr);
+
+/**
+ * @brief 重みはそのままで、data の行から期待値とリスクだけを計算し直す
+ * 各行を推論と同じ BMU 探索（SOMModel::find_bmus、L1）に通し、ノードごとの行数・平均・分散を
+ * 1回の走査で求める（ワーカーごとに Welford 法で積み、最後に合わせる）。
+ * 学習と同じく期待値は平均、リスクは母標準偏差（行が1つなら 0.05）。今回の行が無いノードは model の値のまま。
+ * 結果は SOMEvaluator::relabel() にそのまま渡せる
+ */
+bool relabel_som(const SOMTrainingSet& data, const SOMModel& model, WorkerPool& pool,
+                 std::vector<double>& expectancy, std::vector<double>& risk, SOMRelabelReport* report = nullptr);
+
+#endif
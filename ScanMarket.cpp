@@ -1,118 +1,109 @@
 #include "ScanMarket.h"
-#include <iostream>
-#include <fstream>
-#include <iomanip>
-#include <filesystem>
+#include "RollingWindow.h"
 #include <vector>
-#include <numeric>
 #include <cmath>
-#include <deque>
 #include <chrono>
-#include <map>
 
 // --- データ保存用の構造体 ---
 struct MarketMetrics {
-    std::deque<double> price_history;
-    std::deque<double> btc_price_history;
-    const size_t max_history = 60; // 60秒分
+    static constexpr std::int64_t bucket_ns = 1000000000; // 1秒バケット
+    // 1秒ごとの最終価格を並べた時間窓（ティックの多い少ないに関係なく「直近N秒」になる）
+    // 和と二乗和を差分更新するので、ボラティリティは毎ティック O(1)
+    TimeBucketWindow price_vol;
+    // 1秒ごとの収益率の和・二乗和・BTCとの積和（相関とベータも毎ティック O(1)）
+    TimeBucketCorrelation btc_returns;
+
+    explicit MarketMetrics(const FeatureWindows& w)
+        : price_vol(static_cast<size_t>(w.volatility_sec), bucket_ns),
+          btc_returns(static_cast<size_t>(w.correlation_sec), bucket_ns) {}
 };
 
-// 銘柄ごとの履歴を保持（staticで値を保持し続ける）
-static std::map<std::string, MarketMetrics> market_history;
+// 銘柄ごとの履歴を保持（staticで値を保持し続ける）。SymbolId で引く
+static std::vector<MarketMetrics> market_history;
+static std::vector<std::chrono::steady_clock::time_point> last_save_times;
+
+void init_market_history(size_t symbol_count, const FeatureWindows& windows) {
+    FeatureWindows w = windows;
+    if (w.volatility_sec < 2) w.volatility_sec = 2;
+    if (w.correlation_sec < 2) w.correlation_sec = 2;
+    market_history.clear();
+    market_history.reserve(symbol_count);
+    for (size_t i = 0; i < symbol_count; ++i) market_history.emplace_back(w);
+    last_save_times.assign(symbol_count, std::chrono::steady_clock::time_point{});
+}
 
 // ボラティリティ（価格の荒れ具合）を計算
-// 過去60秒間の価格から標準偏差（ばらつき）を計算
+// 過去N秒間（1秒ごとの価格）の標準偏差（ばらつき）を計算
 // ボラが高い: トレンドが発生するチャンス
 // ボラが低い: 今買っても手数料負けするだけ
 // 今は動かないから手を出さないでおこうという判断ができるようになる
-double calculate_volatility(const std::deque<double>& prices) {
+double calculate_volatility(const TimeBucketWindow& prices) {
     if (prices.size() < 2) return 0.0;
-    double sum = std::accumulate(prices.begin(), prices.end(), 0.0);
-    double mean = sum / prices.size();
-    double sq_sum = 0;
-    for (double p : prices) sq_sum += (p - mean) * (p - mean);
-    return std::sqrt(sq_sum / prices.size()) / mean; 
+    return prices.stddev() / prices.mean();
 }
 
 // BTCとの相関を計算
-// アルトコインの騰落率/BTCの騰落率
-// 値が 1.0 に近い: BTCが1%上がったから、アルトも1%上がった。
-// 値が 5.0 などの大きな値: 個別の強い買いが入った。
+// 窓内の1秒ごとの収益率どうしのピアソン相関
+// 値が 1.0 に近い: BTCと同じ向きに動いている。
+// 値が 0 付近: BTCと関係なく動いている（個別の材料）。
 // 値がマイナス: BTCは上がっているのに、このコインだけ下がっている（逆行、危険）。
-double calculate_btc_correlation(const std::deque<double>& prices, const std::deque<double>& btc_prices) {
-    if (prices.size() < 10 || btc_prices.size() < 10) return 0.0;
-    double p_change = (prices.back() - prices.front()) / prices.front();
-    double b_change = (btc_prices.back() - btc_prices.front()) / btc_prices.front();
-    if (std::abs(b_change) < 0.000001) return 1.0; // BTCが動いてなければ1.0
-    return p_change / b_change;
-}
-
-// --- メインの保存処理 ---
-
-void save_market_data_to_csv(const std::string& symbol, double imbalance, double imbalance_change, 
-                             double total_depth, double current_price, double btc_price,
-                             double vol, double corr) {
-    
-    std::string filename = "data/" + symbol + "_market_data.csv";
-    bool file_exists = std::filesystem::exists(filename);
-    std::ofstream file(filename, std::ios::app);
-    
-    if (!file.is_open()) return;
-
-    // ヘッダー（最初だけ
-    if (!file_exists) {
-        file << "timestamp,symbol,imbalance,imbalance_change,total_depth,price,btc_price,volatility,btc_corr\n";
-    }
+// ベータはBTCが1%動いたときにこのコインが何%動くか。
+// 収益率が10個たまるまで、またはBTCがまったく動いていないときは 0.0
+static constexpr size_t min_corr_returns = 10;
 
-    // 書き込み
-    long long ts = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+double calculate_btc_correlation(const PairMoments& returns) {
+    if (returns.n < static_cast<double>(min_corr_returns)) return 0.0;
+    return returns.correlation();
+}
 
-    file << ts << "," << symbol << ","
-         << std::fixed << std::setprecision(6) << imbalance << ","
-         << imbalance_change << ","
-         << total_depth << ","
-         << current_price << ","
-         << btc_price << ","
-         << vol << ","
-         << corr << "\n";
+double calculate_btc_beta(const PairMoments& returns) {
+    if (returns.n < static_cast<double>(min_corr_returns)) return 0.0;
+    return returns.beta();
 }
 
 // データが届くたびに呼ばれる関数
-void process_ws_data(const std::string& symbol, double imbalance, double imbalance_change,
-                    double total_depth, double current_price, double btc_price,
-                    std::map<std::string, MarketState>& market_state) {
+void process_ws_data(SymbolId id, double imbalance, double imbalance_change,
+                    double total_depth, double current_price, double btc_price, std::int64_t recv_ns,
+                    MarketRecorder::Lane* records, std::vector<MarketState>& market_state) {
     
-    static std::map<std::string, std::chrono::steady_clock::time_point> last_save_times;
     auto now = std::chrono::steady_clock::now();
 
     // 1. 履歴を更新（すべてのデータ受信時に実行）
-    auto& metrics = market_history[symbol];
-    metrics.price_history.push_back(current_price);
-    metrics.btc_price_history.push_back(btc_price);
-    if (metrics.price_history.size() > metrics.max_history) {
-        metrics.price_history.pop_front();
-        metrics.btc_price_history.pop_front();
-    }
+    auto& metrics = market_history[id];
+    metrics.price_vol.update(recv_ns, current_price);
+    metrics.btc_returns.update(recv_ns, current_price, btc_price);
 
     // 2. 指標を計算して、market_state を更新
-    double current_vol = calculate_volatility(metrics.price_history);
-    double current_corr = calculate_btc_correlation(metrics.price_history, metrics.btc_price_history);
+    double current_vol = calculate_volatility(metrics.price_vol);
+    PairMoments returns = metrics.btc_returns.moments();
+    double current_corr = calculate_btc_correlation(returns);
     // 枚数でなくUSDT換算の厚みに変換
     double depth_usdt = total_depth * current_price;
 
-    market_state[symbol].volatility = current_vol;
-    market_state[symbol].btc_corr = current_corr;
-    market_state[symbol].imbalance = imbalance;
-    market_state[symbol].diff = imbalance_change;
-    market_state[symbol].total_depth = depth_usdt;
-    market_state[symbol].last_price = current_price;
+    MarketState& state = market_state[id];
+    state.volatility = current_vol;
+    state.btc_corr = current_corr;
+    state.btc_beta = calculate_btc_beta(returns);
+    state.imbalance = imbalance;
+    state.diff = imbalance_change;
+    state.total_depth = depth_usdt;
+    state.last_price = current_price;
+    state.has_data = true;
 
-    // 1秒に1回だけ保存する（ここですべての引数を渡す）
-    // すでに計算済みなので、vol や corr を直接渡せるように save_market_data_to_csv を改造するべきか
-    if (now - last_save_times[symbol] >= std::chrono::seconds(1)) {
-        save_market_data_to_csv(symbol, imbalance, imbalance_change, depth_usdt, 
-                                current_price, btc_price, current_vol, current_corr);
-        last_save_times[symbol] = now;
+    // 1秒に1回だけ保存する（レコーダーのキューに積むだけ。書き込みは別スレッド）
+    if (records && now - last_save_times[id] >= std::chrono::seconds(1)) {
+        MarketRecord record;
+        record.id = id;
+        record.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.imbalance = imbalance;
+        record.imbalance_change = imbalance_change;
+        record.total_depth = depth_usdt;
+        record.price = current_price;
+        record.btc_price = btc_price;
+        record.volatility = current_vol;
+        record.btc_corr = current_corr;
+        records->push(record);
+        last_save_times[id] = now;
     }
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef SCANMARKET_H
 #define SCANMARKET_H
 
-#include <map>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include <chrono>
+#include <cstdint>
 #include "ExecuteTrade.h"
+#include "FeatureWindows.h"
+#include "MarketRecorder.h"
+#include "SymbolRegistry.h"
 
 struct MarketState {
     double imbalance = 0.0;
@@ -14,15 +17,20 @@ struct MarketState {
     double last_price = 0.0;
     double total_depth = 0.0;
     double volatility = 0.0;
-    double btc_corr = 0.0;      
+    double btc_corr = 0.0;  // BTCとの1秒収益率のピアソン相関（-1 ～ 1）
+    double btc_beta = 0.0;  // BTCに対するベータ（BTCが1%動くと何%動くか）
+    bool has_data = false; // 一度でも process_ws_data で更新されたか
 };
 
-// 板情報をCSVに保存（Python学習用）
-void save_market_data_to_csv(const std::string& symbol, double imbalance, double imbalance_change);
+// 銘柄ごとの履歴バッファを銘柄数ぶん確保する（起動時に1回だけ呼ぶ）
+void init_market_history(size_t symbol_count, const FeatureWindows& windows = FeatureWindows{});
 
 // 板情報を処理（マーケット状態更新・CSV保存）
-void process_ws_data(const std::string& symbol, double imbalance, double imbalance_change,
-                     double total_depth, double current_price, double btc_price,
-                     std::map<std::string, MarketState>& market_state);
+// market_state は SymbolId で引く配列。symbol はCSVのファイル名・行に使う
+// recv_ns は板の受信時刻（monotonic_ns）。時間窓のバケット分けに使う
+// records は呼び出し元スレッド専用のレコーダーのキュー（1秒に1行積む。nullptr なら保存しない）
+void process_ws_data(SymbolId id, double imbalance, double imbalance_change,
+                     double total_depth, double current_price, double btc_price, std::int64_t recv_ns,
+                     MarketRecorder::Lane* records, std::vector<MarketState>& market_state);
 
 #endif
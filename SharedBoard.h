@@ -0,0 +1,57 @@
+#ifndef SHAREDBOARD_H
+#define SHAREDBOARD_H
+
+#include "SymbolRegistry.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 銘柄ごとの最新値をシャード間で共有する掲示板
+ * 書き手はその銘柄を担当するシャードのストラテジースレッド1本だけ。
+ * 他のシャード（BTC基準価格の参照）やメインループ（決済判定）はロックなしで読む。
+ */
+class SharedBoard {
+public:
+    explicit SharedBoard(size_t symbol_count)
+        : entries_(std::make_unique<Entry[]>(symbol_count)), size_(symbol_count) {}
+
+    void publish(SymbolId id, double mid_price, double imbalance, double diff, std::int64_t recv_ns) {
+        Entry& e = entries_[id];
+        e.recv_ns.store(recv_ns, std::memory_order_relaxed);
+        e.imbalance.store(imbalance, std::memory_order_relaxed);
+        e.diff.store(diff, std::memory_order_relaxed);
+        e.mid_price.store(mid_price, std::memory_order_release);
+    }
+
+    // 未受信の銘柄は 0.0
+    double mid_price(SymbolId id) const { return entries_[id].mid_price.load(std::memory_order_acquire); }
+    double imbalance(SymbolId id) const { return entries_[id].imbalance.load(std::memory_order_relaxed); }
+    double diff(SymbolId id) const { return entries_[id].diff.load(std::memory_order_relaxed); }
+
+    // 決済判定用に全銘柄の価格とその受信時刻（monotonic_ns）を配列へ写す
+    void snapshot_prices(std::vector<double>& prices, std::vector<std::int64_t>& recv_ns) const {
+        prices.resize(size_);
+        recv_ns.resize(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            prices[i] = entries_[i].mid_price.load(std::memory_order_acquire);
+            recv_ns[i] = entries_[i].recv_ns.load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    struct alignas(64) Entry {
+        std::atomic<double> mid_price{0.0};
+        std::atomic<double> imbalance{0.0};
+        std::atomic<double> diff{0.0};
+        std::atomic<std::int64_t> recv_ns{0};
+    };
+
+    std::unique_ptr<Entry[]> entries_;
+    size_t size_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief 単一プロデューサ・単一コンシューマのロックフリー固定長リング
+ * Capacity は2の冪。スロットは事前確保し、push/pop でヒープ確保はしない。
+ * プロデューサは prepare_push() で空きスロットに直接書き込み commit_push() で公開、
+ * コンシューマは front() で読み pop() で解放する（コピーを1回で済ませるため）。
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscRing() : slots_(new T[Capacity]) {}
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // --- プロデューサ側 ---
+
+    // 書き込み先スロット。満杯なら nullptr
+    T* prepare_push() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ >= Capacity) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ >= Capacity) return nullptr;
+        }
+        return &slots_[head & (Capacity - 1)];
+    }
+
+    void commit_push() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool try_push(const T& value) {
+        T* slot = prepare_push();
+        if (!slot) return false;
+        *slot = value;
+        commit_push();
+        return true;
+    }
+
+    // --- コンシューマ側 ---
+
+    // 先頭要素。空なら nullptr
+    T* front() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_) return nullptr;
+        }
+        return &slots_[tail & (Capacity - 1)];
+    }
+
+    void pop() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // --- どちらのスレッドからでも呼べる（目安の値） ---
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return head - tail;
+    }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    std::unique_ptr<T[]> slots_;
+
+    // プロデューサとコンシューマが別キャッシュラインを触るように分ける
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0; // プロデューサ専用
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0; // コンシューマ専用
+};
+
+#endif
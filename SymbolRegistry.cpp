@@ -0,0 +1,44 @@
+#include "SymbolRegistry.h"
+
+SymbolId SymbolRegistry::add(const std::string& symbol) {
+    SymbolId existing = find(symbol);
+    if (existing != INVALID_SYMBOL) return existing;
+
+    names_.push_back(symbol);
+    rebuild_table();
+    return static_cast<SymbolId>(names_.size() - 1);
+}
+
+SymbolId SymbolRegistry::find(std::string_view symbol) const {
+    if (table_.empty()) return INVALID_SYMBOL;
+    size_t mask = table_.size() - 1;
+    for (size_t i = hash(symbol) & mask; ; i = (i + 1) & mask) {
+        SymbolId id = table_[i];
+        if (id == INVALID_SYMBOL) return INVALID_SYMBOL;
+        if (names_[id] == symbol) return id;
+    }
+}
+
+// FNV-1a（銘柄名は短いので十分）
+std::uint32_t SymbolRegistry::hash(std::string_view s) {
+    std::uint32_t h = 2166136261u;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 負荷率を50%以下に保つように表を作り直す（登録は起動時だけなので毎回作り直してよい）
+void SymbolRegistry::rebuild_table() {
+    size_t capacity = 16;
+    while (capacity < names_.size() * 2) capacity *= 2;
+    table_.assign(capacity, INVALID_SYMBOL);
+
+    size_t mask = capacity - 1;
+    for (size_t id = 0; id < names_.size(); ++id) {
+        size_t i = hash(names_[id]) & mask;
+        while (table_[i] != INVALID_SYMBOL) i = (i + 1) & mask;
+        table_[i] = static_cast<SymbolId>(id);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef SYMBOLREGISTRY_H
+#define SYMBOLREGISTRY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 銘柄ID（0から始まる連番）。銘柄ごとの状態は std::vector をこのIDで引く
+using SymbolId = std::uint16_t;
+constexpr SymbolId INVALID_SYMBOL = 0xFFFF;
+
+/**
+ * @brief 起動時に銘柄名 → 連番IDの対応表を作るクラス
+ * 文字列を扱うのは受信直後の find() の1回だけで、それ以降のホットパスはIDだけで動く。
+ * 登録は起動時にのみ行い、以降は読み取り専用（スレッド間で共有してよい）。
+ */
+class SymbolRegistry {
+public:
+    /**
+     * @brief 銘柄を登録してIDを返す（登録済みなら既存のIDを返す）
+     */
+    SymbolId add(const std::string& symbol);
+
+    /**
+     * @brief 銘柄名からIDを引く（未登録なら INVALID_SYMBOL）
+     * 開番地法のハッシュ表なので、確保も std::map の木探索もしない
+     */
+    SymbolId find(std::string_view symbol) const;
+
+    const std::string& name(SymbolId id) const { return names_[id]; }
+    size_t size() const { return names_.size(); }
+
+    /**
+     * @brief BTCなど、全銘柄が参照する基準銘柄
+     */
+    void set_reference(SymbolId id) { reference_id_ = id; }
+    SymbolId reference_id() const { return reference_id_; }
+
+private:
+    static std::uint32_t hash(std::string_view s);
+    void rebuild_table();
+
+    std::vector<std::string> names_;
+    std::vector<SymbolId> table_; // サイズは2の冪。空きは INVALID_SYMBOL
+    SymbolId reference_id_ = INVALID_SYMBOL;
+};
+
+#endif
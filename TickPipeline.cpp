@@ -0,0 +1,200 @@
+#include "TickPipeline.h"
+#include "BookTicker.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool pin_current_thread(int cpu) {
+    if (cpu < 0) return false;
+#ifdef _WIN32
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+TickPipeline::TickPipeline(const SymbolRegistry& registry, Mode mode, Handler handler,
+                           std::vector<SymbolId> symbol_ids)
+    : registry_(registry), mode_(mode), handler_(std::move(handler)), symbol_ids_(std::move(symbol_ids)) {
+    if (symbol_ids_.empty()) {
+        for (size_t i = 0; i < registry_.size(); ++i) symbol_ids_.push_back(static_cast<SymbolId>(i));
+    }
+    if (mode_ == Mode::Queue) {
+        ring_ = std::make_unique<SpscRing<RawFrame, RING_CAPACITY>>();
+    } else {
+        slots_ = std::make_unique<ConflationSlot[]>(registry_.size());
+        consumed_seq_.assign(registry_.size(), 0);
+    }
+}
+
+void TickPipeline::start(int cpu) {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread([this, cpu]() {
+        if (cpu >= 0 && !pin_current_thread(cpu)) {
+            std::cerr << "Failed to pin strategy thread to CPU " << cpu << std::endl;
+        }
+        run();
+    });
+}
+
+void TickPipeline::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+}
+
+bool TickPipeline::push_frame(std::string_view frame, std::int64_t recv_ns) {
+    if (mode_ == Mode::Conflate) return publish_latest(frame, recv_ns);
+
+    if (frame.size() > RawFrame::MAX_SIZE) {
+        oversize_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    RawFrame* slot = ring_->prepare_push();
+    if (!slot) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slot->recv_ns = recv_ns;
+    slot->len = static_cast<std::uint32_t>(frame.size());
+    std::memcpy(slot->data, frame.data(), frame.size());
+    ring_->commit_push();
+
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+    size_t depth = ring_->size();
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+TickPipeline::Stats TickPipeline::stats() const {
+    Stats s;
+    s.pushed = pushed_.load(std::memory_order_relaxed);
+    s.processed = processed_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.oversize = oversize_.load(std::memory_order_relaxed);
+    s.conflated = conflated_.load(std::memory_order_relaxed);
+    s.decode_errors = decode_errors_.load(std::memory_order_relaxed);
+    s.occupancy = ring_ ? ring_->size() : 0;
+    s.high_water = high_water_.load(std::memory_order_relaxed);
+    s.capacity = ring_ ? RING_CAPACITY : 0;
+    return s;
+}
+
+bool TickPipeline::decode(std::string_view frame, std::int64_t recv_ns, BookQuote& out) {
+    BookTicker tick;
+    if (decode_book_ticker(frame, tick) != BookTickerError::Ok) {
+        decode_errors_.fetch_add(1, std::memory_order_relaxed);
+        return false; // bookTicker 以外のメッセージ、または壊れたメッセージ
+    }
+    out.id = registry_.find(tick.symbol);
+    if (out.id == INVALID_SYMBOL) return false;
+    out.recv_ns = recv_ns;
+    out.bid_price = tick.bid_price;
+    out.ask_price = tick.ask_price;
+    out.bid_volume = tick.bid_volume;
+    out.ask_volume = tick.ask_volume;
+    out.parsed_ns = monotonic_ns();
+    return true;
+}
+
+// Conflate モードの書き込み（受信スレッド）
+// シーケンス番号を奇数にしてから書き、偶数に戻して公開する
+bool TickPipeline::publish_latest(std::string_view frame, std::int64_t recv_ns) {
+    BookQuote q;
+    if (!decode(frame, recv_ns, q)) return false;
+
+    ConflationSlot& slot = slots_[q.id];
+    std::uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.recv_ns.store(q.recv_ns, std::memory_order_relaxed);
+    slot.parsed_ns.store(q.parsed_ns, std::memory_order_relaxed);
+    slot.bid_price.store(q.bid_price, std::memory_order_relaxed);
+    slot.ask_price.store(q.ask_price, std::memory_order_relaxed);
+    slot.bid_volume.store(q.bid_volume, std::memory_order_relaxed);
+    slot.ask_volume.store(q.ask_volume, std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+
+    // まだ処理されていない板を上書きしたら、その分は間引かれたことになる
+    if (slot.pending.exchange(true, std::memory_order_acq_rel)) {
+        conflated_.fetch_add(1, std::memory_order_relaxed);
+    }
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Queue モードの取り出し（順番どおり全件）
+bool TickPipeline::drain_queue() {
+    bool any = false;
+    while (RawFrame* frame = ring_->front()) {
+        BookQuote q;
+        if (decode(frame->view(), frame->recv_ns, q)) {
+            handler_(q);
+            processed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        ring_->pop();
+        any = true;
+    }
+    return any;
+}
+
+// Conflate モードの取り出し（未処理の銘柄ごとに最新の板を1件ずつ）
+bool TickPipeline::drain_latest() {
+    bool any = false;
+    for (SymbolId i : symbol_ids_) {
+        ConflationSlot& slot = slots_[i];
+        if (!slot.pending.load(std::memory_order_relaxed)) continue;
+        // 先にフラグを下ろす。読んでいる最中に上書きされたら次の周回でもう一度処理する
+        slot.pending.exchange(false, std::memory_order_acq_rel);
+
+        BookQuote q;
+        q.id = i;
+        std::uint32_t before, after;
+        do {
+            before = slot.seq.load(std::memory_order_acquire);
+            q.recv_ns = slot.recv_ns.load(std::memory_order_relaxed);
+            q.parsed_ns = slot.parsed_ns.load(std::memory_order_relaxed);
+            q.bid_price = slot.bid_price.load(std::memory_order_relaxed);
+            q.ask_price = slot.ask_price.load(std::memory_order_relaxed);
+            q.bid_volume = slot.bid_volume.load(std::memory_order_relaxed);
+            q.ask_volume = slot.ask_volume.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.seq.load(std::memory_order_relaxed);
+        } while ((before & 1u) != 0 || before != after);
+
+        // フラグを下ろした直後の上書きを既に読んでいた場合、同じ板を二度処理しない
+        if (after == consumed_seq_[i]) continue;
+        consumed_seq_[i] = after;
+
+        handler_(q);
+        processed_.fetch_add(1, std::memory_order_relaxed);
+        any = true;
+    }
+    return any;
+}
+
+// ストラテジースレッド本体
+// 空のときはしばらくスピンし、それでも来なければ yield → 短いスリープと段階的に引く
+void TickPipeline::run() {
+    int idle = 0;
+    while (running_.load(std::memory_order_relaxed)) {
+        bool any = (mode_ == Mode::Queue) ? drain_queue() : drain_latest();
+        if (any) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < 64) continue;
+        if (idle < 256) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef TICKPIPELINE_H
+#define TICKPIPELINE_H
+
+#include "SpscRing.h"
+#include "SymbolRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 単調増加時計（ns）。受信時刻などのタイムスタンプに使う
+inline std::int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 呼び出したスレッドを指定CPUに固定する（失敗時 false）
+bool pin_current_thread(int cpu);
+
+/**
+ * @brief 受信スレッドからストラテジースレッドへ渡す生フレーム
+ * bookTicker は200バイト程度なので固定長スロットに丸ごとコピーする
+ */
+struct RawFrame {
+    static constexpr size_t MAX_SIZE = 512 - sizeof(std::int64_t) - sizeof(std::uint32_t);
+
+    std::int64_t recv_ns = 0; // 受信時刻（monotonic_ns）
+    std::uint32_t len = 0;
+    char data[MAX_SIZE];
+
+    std::string_view view() const { return std::string_view(data, len); }
+};
+
+/**
+ * @brief デコード済みの板（ストラテジースレッドの handler に渡す）
+ */
+struct BookQuote {
+    SymbolId id = INVALID_SYMBOL;
+    std::int64_t recv_ns = 0;   // 受信時刻（monotonic_ns）
+    std::int64_t parsed_ns = 0; // デコード完了時刻（monotonic_ns）
+    double bid_price = 0.0;
+    double ask_price = 0.0;
+    double bid_volume = 0.0;
+    double ask_volume = 0.0;
+};
+
+/**
+ * @brief 受信コールバックとトレード処理を切り離すパイプライン
+ * WebSocket の受信スレッドは push_frame() で積むだけ。
+ * 専用のストラテジースレッドが取り出して handler を呼ぶ。
+ *
+ * Queue モード   : 生フレームをSPSCリングに積み、ストラテジースレッドで順番どおりに全件処理する
+ * Conflate モード: 受信スレッドでデコードし、銘柄ごとの最新値スロットを上書きする。
+ *                  ストラテジースレッドが遅れても、各銘柄の最新の板だけを処理する
+ */
+class TickPipeline {
+public:
+    static constexpr size_t RING_CAPACITY = 4096;
+    using Handler = std::function<void(const BookQuote&)>;
+
+    enum class Mode { Queue, Conflate };
+
+    struct Stats {
+        std::uint64_t pushed = 0;        // 受け付けた数
+        std::uint64_t processed = 0;     // handler まで処理した数
+        std::uint64_t dropped = 0;       // リング満杯で捨てた数
+        std::uint64_t oversize = 0;      // スロットに収まらず捨てた数
+        std::uint64_t conflated = 0;     // 未処理の板を新しい板で上書きした数（Conflate モード）
+        std::uint64_t decode_errors = 0; // bookTicker として読めなかった数（購読応答を含む）
+        size_t occupancy = 0;            // 現在のリング使用数
+        size_t high_water = 0;           // リング使用数の最大値
+        size_t capacity = RING_CAPACITY;
+    };
+
+    /**
+     * @param symbol_ids このパイプラインが担当する銘柄（Conflate モードで走査する対象。空なら全銘柄）
+     */
+    TickPipeline(const SymbolRegistry& registry, Mode mode, Handler handler,
+                 std::vector<SymbolId> symbol_ids = {});
+    ~TickPipeline() { stop(); }
+    TickPipeline(const TickPipeline&) = delete;
+    TickPipeline& operator=(const TickPipeline&) = delete;
+
+    /**
+     * @brief ストラテジースレッドを起動する
+     * @param cpu 固定するCPU番号（負ならピン留めしない）
+     */
+    void start(int cpu);
+    void stop();
+
+    /**
+     * @brief 受信スレッドから呼ぶ。Queue モードではコピーしてリングに積むだけで、満杯なら捨てて false
+     */
+    bool push_frame(std::string_view frame, std::int64_t recv_ns);
+
+    Mode mode() const { return mode_; }
+    Stats stats() const;
+
+private:
+    // 銘柄ごとの最新値スロット（シーケンスロック）。書き手は受信スレッド1本だけ
+    struct alignas(64) ConflationSlot {
+        std::atomic<std::uint32_t> seq{0};  // 奇数の間は書き込み中
+        std::atomic<bool> pending{false};   // 未処理の板がある
+        std::atomic<std::int64_t> recv_ns{0};
+        std::atomic<std::int64_t> parsed_ns{0};
+        std::atomic<double> bid_price{0.0};
+        std::atomic<double> ask_price{0.0};
+        std::atomic<double> bid_volume{0.0};
+        std::atomic<double> ask_volume{0.0};
+    };
+
+    bool decode(std::string_view frame, std::int64_t recv_ns, BookQuote& out);
+    bool publish_latest(std::string_view frame, std::int64_t recv_ns);
+    bool drain_queue();
+    bool drain_latest();
+    void run();
+
+    const SymbolRegistry& registry_;
+    Mode mode_;
+    Handler handler_;
+    std::unique_ptr<SpscRing<RawFrame, RING_CAPACITY>> ring_; // Queue モードのみ
+    std::unique_ptr<ConflationSlot[]> slots_;                 // Conflate モードのみ
+    std::vector<SymbolId> symbol_ids_;
+    std::vector<std::uint32_t> consumed_seq_;                 // 最後に処理したシーケンス番号（ストラテジースレッド専用）
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // 受信スレッドが書くカウンタ
+    std::atomic<std::uint64_t> pushed_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> oversize_{0};
+    std::atomic<size_t> high_water_{0};
+    std::atomic<std::uint64_t> conflated_{0};
+    // ストラテジースレッドが書くカウンタ（Conflate モードでは decode_errors_ は受信スレッド）
+    std::atomic<std::uint64_t> processed_{0};
+    std::atomic<std::uint64_t> decode_errors_{0};
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threads) {
+    if (threads == 0) {
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        threads = cpus - 1;
+    }
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) workers_.emplace_back([this]() { worker_loop(); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& w : workers_) w.join();
+}
+
+void WorkerPool::work_on(Job& job) {
+    size_t slot = static_cast<size_t>(-1);
+    while (true) {
+        size_t chunk = job.next.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job.chunks) break;
+        // チャンクを1つでも取ったスレッドだけが slot をもらう
+        if (slot == static_cast<size_t>(-1)) slot = job.next_slot.fetch_add(1, std::memory_order_relaxed);
+        size_t begin = chunk * job.grain;
+        size_t end = std::min(job.count, begin + job.grain);
+        (*job.fn)(begin, end, slot);
+        if (job.done.fetch_add(1, std::memory_order_acq_rel) + 1 == job.chunks) {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.finished.notify_all();
+        }
+    }
+}
+
+void WorkerPool::worker_loop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (stopping_) return;
+            job = jobs_.front();
+        }
+        work_on(*job);
+        // チャンクは取り尽くしたので、まだ並んでいれば外す
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end()) jobs_.erase(it);
+    }
+}
+
+void WorkerPool::parallel_for(size_t count, size_t grain, const ChunkFn& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(1, grain);
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+    job->grain = grain;
+    job->chunks = (count + grain - 1) / grain;
+
+    if (job->chunks > 1 && !workers_.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(job);
+        }
+        wake_.notify_all();
+    }
+    work_on(*job);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(jobs_.begin(), jobs_.end(), job);
+        if (it != jobs_.end()) jobs_.erase(it);
+    }
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&]() { return job->done.load(std::memory_order_acquire) == job->chunks; });
+}
@@ -0,0 +1,60 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 学習用の固定スレッドプール
+ * parallel_for() は [0, count) を grain ずつのチャンクに分け、ワーカーと呼び出し元のスレッドで取り合って処理する。
+ * 呼び出し元も自分でチャンクを取るので、ワーカーが全員ふさがっていても（parallel_for の中から
+ * parallel_for を呼んでも）止まらずに終わる。
+ */
+class WorkerPool {
+public:
+    // fn(begin, end, slot)。slot は 0..slots()-1 で、同時に走る呼び出しどうしで重ならない（スレッドごとの作業領域用）
+    using ChunkFn = std::function<void(size_t begin, size_t end, size_t slot)>;
+
+    // threads = 0 ならCPU数 - 1（呼び出し元のスレッドも働くので）
+    explicit WorkerPool(unsigned threads = 0);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // 1つの parallel_for の中で同時に fn を実行しうるスレッドの数（ワーカー + 呼び出し元）
+    size_t slots() const { return workers_.size() + 1; }
+
+    void parallel_for(size_t count, size_t grain, const ChunkFn& fn);
+
+private:
+    struct Job {
+        const ChunkFn* fn = nullptr;
+        size_t count = 0;
+        size_t grain = 1;
+        size_t chunks = 0;
+        std::atomic<size_t> next{0};     // 次に取るチャンク
+        std::atomic<size_t> done{0};     // 終わったチャンク
+        std::atomic<size_t> next_slot{0}; // 参加したスレッドに配る slot
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    // job のチャンクを取れるだけ取って実行する
+    static void work_on(Job& job);
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stopping_ = false;
+};
+
+#endif
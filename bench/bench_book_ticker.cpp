@@ -0,0 +1,94 @@
+// bookTicker デコードのベンチマーク
+// 旧実装（nlohmann::json + std::stod）と decode_book_ticker の1メッセージあたりの時間を比較する
+#include "../BookTicker.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+std::vector<std::string> make_frames(size_t count) {
+    const char* symbols[] = {"ATOMUSDT", "ETHUSDT", "SOLUSDT", "BTCUSDT"};
+    std::vector<std::string> frames;
+    frames.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string sym = symbols[i % 4];
+        std::string lower = sym;
+        for (auto& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        double base = 100.0 + static_cast<double>(i % 1000) * 0.01;
+        frames.push_back("{\"stream\":\"" + lower + "@bookTicker\",\"data\":{\"u\":" + std::to_string(400900217 + i) +
+                         ",\"s\":\"" + sym + "\",\"b\":\"" + std::to_string(base) + "\",\"B\":\"31.21000000\"" +
+                         ",\"a\":\"" + std::to_string(base + 0.01) + "\",\"A\":\"40.66000000\"}}");
+    }
+    return frames;
+}
+
+// 旧実装と同じ手順
+bool decode_with_json(const std::string& frame, BookTicker& out, std::string& symbol) {
+    try {
+        auto root = json::parse(frame);
+        auto data = root.count("data") ? root["data"] : root;
+        if (!data.contains("s")) return false;
+        symbol = data["s"];
+        out.bid_price = std::stod(data["b"].get<std::string>());
+        out.ask_price = std::stod(data["a"].get<std::string>());
+        out.bid_volume = std::stod(data["B"].get<std::string>());
+        out.ask_volume = std::stod(data["A"].get<std::string>());
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+int main() {
+    const size_t frame_count = 4096;
+    const int rounds = 200;
+    auto frames = make_frames(frame_count);
+
+    // 結果が一致するか先に確認
+    for (const auto& f : frames) {
+        BookTicker a, b;
+        std::string sym;
+        if (!decode_with_json(f, a, sym) || decode_book_ticker(f, b) != BookTickerError::Ok ||
+            sym != b.symbol || a.bid_price != b.bid_price || a.ask_price != b.ask_price ||
+            a.bid_volume != b.bid_volume || a.ask_volume != b.ask_volume) {
+            std::cerr << "Mismatch on frame: " << f << std::endl;
+            return 1;
+        }
+    }
+
+    double sink = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& f : frames) {
+            BookTicker t;
+            std::string sym;
+            if (decode_with_json(f, t, sym)) sink += t.bid_price;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& f : frames) {
+            BookTicker t;
+            if (decode_book_ticker(f, t) == BookTickerError::Ok) sink += t.bid_price;
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double n = static_cast<double>(frame_count) * rounds;
+    double json_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double fast_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+
+    std::cout << "json::parse + stod : " << json_ns << " ns/msg" << std::endl;
+    std::cout << "decode_book_ticker : " << fast_ns << " ns/msg" << std::endl;
+    std::cout << "speedup            : " << json_ns / fast_ns << "x" << std::endl;
+    std::cout << "(checksum " << sink << ")" << std::endl;
+    return 0;
+}
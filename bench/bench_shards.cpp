@@ -0,0 +1,101 @@
+// シャード分割したパイプラインのスループット計測
+// 4 / 32 / 128 銘柄を、シャード数ぶんの「受信スレッド」から合成フレームで流し込み、
+// ストラテジースレッドが処理できた件数/秒を測る（ソケットは使わず TickPipeline 以降を測る）
+//
+// 使い方: bench_shards [shards] [seconds]
+#include "../MarketShard.h"
+#include "../SharedBoard.h"
+#include "../SymbolRegistry.h"
+#include "../TickPipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string make_frame(const std::string& symbol, int seq) {
+    std::string lower = symbol;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    double base = 100.0 + (seq % 100) * 0.01;
+    return "{\"stream\":\"" + lower + "@bookTicker\",\"data\":{\"u\":" + std::to_string(400900217 + seq) +
+           ",\"s\":\"" + symbol + "\",\"b\":\"" + std::to_string(base) + "\",\"B\":\"31.21000000\"" +
+           ",\"a\":\"" + std::to_string(base + 0.01) + "\",\"A\":\"40.66000000\"}}";
+}
+
+void run_case(size_t symbol_count, int shard_count, TickPipeline::Mode mode, double seconds) {
+    SymbolRegistry registry;
+    for (size_t i = 0; i + 1 < symbol_count; ++i) registry.add("SYM" + std::to_string(i) + "USDT");
+    SymbolId btc_id = registry.add("BTCUSDT");
+    registry.set_reference(btc_id);
+
+    SharedBoard board(registry.size());
+    // 本番の on_quote のうち、掲示板への書き込みまで（指標の計算と推論は含まない）
+    auto handler = [&](const BookQuote& q) {
+        double mid = (q.bid_price + q.ask_price) / 2.0;
+        double imbalance = (q.bid_volume - q.ask_volume) / (q.bid_volume + q.ask_volume);
+        board.publish(q.id, mid, imbalance, imbalance - board.imbalance(q.id), q.recv_ns);
+    };
+
+    auto groups = partition_symbols(registry.size(), shard_count);
+    std::vector<std::unique_ptr<TickPipeline>> pipelines;
+    std::vector<std::vector<std::string>> frames(groups.size());
+    for (size_t k = 0; k < groups.size(); ++k) {
+        pipelines.push_back(std::make_unique<TickPipeline>(registry, mode, handler, groups[k]));
+        for (int seq = 0; seq < 64; ++seq) {
+            for (SymbolId id : groups[k]) frames[k].push_back(make_frame(registry.name(id), seq));
+        }
+    }
+    for (size_t k = 0; k < pipelines.size(); ++k) pipelines[k]->start(-1);
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> producers;
+    for (size_t k = 0; k < pipelines.size(); ++k) {
+        producers.emplace_back([&, k]() {
+            size_t i = 0;
+            const auto& fs = frames[k];
+            while (running.load(std::memory_order_relaxed)) {
+                pipelines[k]->push_frame(fs[i], monotonic_ns());
+                if (++i == fs.size()) i = 0;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    for (auto& t : producers) t.join();
+    for (auto& p : pipelines) p->stop();
+
+    TickPipeline::Stats total;
+    for (auto& p : pipelines) {
+        auto st = p->stats();
+        total.pushed += st.pushed;
+        total.processed += st.processed;
+        total.dropped += st.dropped;
+        total.conflated += st.conflated;
+    }
+    std::cout << (mode == TickPipeline::Mode::Queue ? "queue   " : "conflate")
+              << " symbols=" << symbol_count << " shards=" << groups.size()
+              << " processed/s=" << static_cast<double>(total.processed) / seconds
+              << " pushed/s=" << static_cast<double>(total.pushed) / seconds
+              << " dropped=" << total.dropped << " conflated=" << total.conflated << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int shards = argc > 1 ? std::atoi(argv[1]) : 4;
+    double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+
+    for (size_t symbols : {4, 32, 128}) {
+        int s = std::min<int>(shards, static_cast<int>(symbols));
+        run_case(symbols, s, TickPipeline::Mode::Queue, seconds);
+        run_case(symbols, s, TickPipeline::Mode::Conflate, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+// SOM の BMU 探索のベンチマーク
+// 旧実装（vector<vector<double>> を走査しながらスケーリング）と、連続領域のスカラー / AVX2 カーネルの
+// 1推論あたりの時間と、旧実装と違うノードを選んだ回数を比較する。
+// 次に前回のBMUの近傍から探す find_bmu_near() を、少しずつ動く入力（ティックごとの特徴量に近い）で全探索と比べ、
+// 最後に SOMEvaluator::getPredictions()（まとめて推論）を1行ずつの getPrediction() と比べる
+#include "../SOMEvaluator.h"
+#include "../SOMKernels.h"
+#include "../SOMModel.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 旧 SOMEvaluator::getPrediction と同じ計算（BMU の番号を返す）
+size_t bmu_legacy(const std::vector<std::vector<double>>& map_weights,
+                  const std::vector<double>& mins, const std::vector<double>& maxs,
+                  const std::vector<double>& raw_data) {
+    std::vector<double> scaled_data(raw_data.size());
+    for (size_t i = 0; i < raw_data.size(); ++i) {
+        double range = maxs[i] - mins[i];
+        scaled_data[i] = (range < 1e-9) ? 0.5 : (raw_data[i] - mins[i]) / range;
+    }
+    double min_dist = 1e18;
+    size_t best_idx = 0;
+    for (size_t i = 0; i < map_weights.size(); ++i) {
+        double d = 0;
+        for (size_t j = 0; j < scaled_data.size(); ++j) d += std::abs(map_weights[i][j] - scaled_data[j]);
+        if (d < min_dist) {
+            min_dist = d;
+            best_idx = i;
+        }
+    }
+    return best_idx;
+}
+
+void run(size_t width, size_t height, size_t features) {
+    const size_t nodes = width * height;
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<std::vector<double>> weights(nodes, std::vector<double>(features));
+    for (auto& row : weights)
+        for (auto& w : row) w = unit(rng);
+    std::vector<double> mins(features, -1.0), maxs(features, 1.0);
+    SOMModel model;
+    model.build(weights, width, height, mins, maxs, std::vector<double>(nodes, 0.0), {});
+
+    const size_t n = 200000;
+    std::vector<std::vector<double>> inputs(n, std::vector<double>(features));
+    for (auto& row : inputs)
+        for (auto& x : row) x = unit(rng) * 2.0 - 1.0;
+
+    // 汎用版（スカラー / AVX2）と、この stride 向けの特化版
+    const BmuKernel kernels[] = {&bmu_l1_scalar, cpu_has_avx2() ? &bmu_l1_avx2 : nullptr,
+                                 select_bmu_kernel(model.stride)};
+    alignas(64) double x[SOMModel::MAX_FEATURES];
+
+    size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& raw : inputs) sink += bmu_legacy(weights, mins, maxs, raw);
+    auto t1 = std::chrono::steady_clock::now();
+    double legacy_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+
+    std::cout << width << "x" << height << " features=" << features
+              << " | legacy " << legacy_ns << " ns/prediction";
+    for (BmuKernel kernel : kernels) {
+        if (!kernel) continue;
+        size_t mismatch = 0;
+        for (const auto& raw : inputs) {
+            model.scale(raw.data(), x);
+            if (kernel(model.weights.data(), model.node_count, model.stride, x, nullptr) !=
+                bmu_legacy(weights, mins, maxs, raw)) {
+                ++mismatch;
+            }
+        }
+        auto k0 = std::chrono::steady_clock::now();
+        for (const auto& raw : inputs) {
+            model.scale(raw.data(), x);
+            sink += kernel(model.weights.data(), model.node_count, model.stride, x, nullptr);
+        }
+        auto k1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(k1 - k0).count() / n;
+        std::cout << " | " << bmu_kernel_name(kernel) << " " << ns << " ns/prediction"
+                  << " (x" << legacy_ns / ns << ", mismatch " << mismatch << ")";
+    }
+    std::cout << " (checksum " << sink << ")" << std::endl;
+}
+
+// 学習済みのマップに近い、2次元の面に沿ってなめらかに変わる特徴量（面上の座標 u, v ∈ [0, 1]）
+struct SmoothSurface {
+    std::vector<double> a, b, c;
+
+    SmoothSurface(size_t features, std::mt19937_64& rng) : a(features), b(features), c(features) {
+        std::uniform_real_distribution<double> phase(0.0, 3.0);
+        for (size_t f = 0; f < features; ++f) {
+            a[f] = phase(rng);
+            b[f] = phase(rng);
+            c[f] = phase(rng);
+        }
+    }
+    double at(size_t f, double u, double v) const { return 0.5 + 0.4 * std::sin(a[f] * u + b[f] * v + c[f]); }
+};
+
+void run_coherent(size_t width, size_t height, size_t features, double step) {
+    const size_t nodes = width * height;
+    std::mt19937_64 rng(11);
+    SmoothSurface surface(features, rng);
+
+    // 面をグリッドで覆うマップ（隣のノードほど重みが近い）
+    std::vector<std::vector<double>> weights(nodes, std::vector<double>(features));
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            for (size_t f = 0; f < features; ++f) {
+                weights[y * width + x][f] = surface.at(f, double(x) / (width - 1), double(y) / (height - 1));
+            }
+        }
+    }
+    std::vector<double> mins(features, 0.0), maxs(features, 1.0);
+    SOMModel model;
+    model.build(weights, width, height, mins, maxs, std::vector<double>(nodes, 0.0), {});
+
+    // 面上の点がランダムウォークし、各特徴量に小さなノイズが乗る入力
+    const size_t n = 200000;
+    std::normal_distribution<double> walk(0.0, step);
+    std::normal_distribution<double> noise(0.0, 0.005);
+    std::vector<double> inputs(n * features);
+    double u = 0.5, v = 0.5;
+    for (size_t i = 0; i < n; ++i) {
+        u = std::min(1.0, std::max(0.0, u + walk(rng)));
+        v = std::min(1.0, std::max(0.0, v + walk(rng)));
+        for (size_t f = 0; f < features; ++f) inputs[i * features + f] = surface.at(f, u, v) + noise(rng);
+    }
+
+    alignas(64) double x[SOMModel::MAX_FEATURES];
+    size_t mismatch = 0, hits = 0, prev = 0, sink = 0;
+    for (size_t i = 0; i < n; ++i) {
+        model.scale(&inputs[i * features], x);
+        bool hit;
+        size_t near = model.find_bmu_near(x, prev, nullptr, hit);
+        if (near != model.find_bmu(x)) ++mismatch;
+        hits += hit;
+        prev = near;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        model.scale(&inputs[i * features], x);
+        sink += model.find_bmu(x);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    prev = 0;
+    for (size_t i = 0; i < n; ++i) {
+        model.scale(&inputs[i * features], x);
+        bool hit;
+        prev = model.find_bmu_near(x, prev, nullptr, hit);
+        sink += prev;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double full_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double near_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+    std::cout << "coherent " << width << "x" << height << " features=" << features << " step=" << step
+              << " | full " << full_ns << " ns | near " << near_ns << " ns (x" << full_ns / near_ns << ")"
+              << " | hit rate " << 100.0 * hits / n << "% | mismatch " << mismatch
+              << " (checksum " << sink << ")" << std::endl;
+}
+
+void run_batch(size_t width, size_t height, size_t features) {
+    const size_t nodes = width * height;
+    std::mt19937_64 rng(13);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<std::vector<double>> weights(nodes, std::vector<double>(features));
+    for (auto& row : weights)
+        for (auto& w : row) w = unit(rng);
+    std::vector<double> expectancy(nodes);
+    for (auto& e : expectancy) e = unit(rng);
+    auto model = std::make_unique<SOMModel>();
+    model->build(weights, width, height, std::vector<double>(features, 0.0), std::vector<double>(features, 1.0),
+                 expectancy, {});
+    SOMEvaluator som;
+    som.publish(std::move(model));
+
+    const size_t n = 200000;
+    std::vector<double> rows(n * features);
+    for (auto& x : rows) x = unit(rng);
+    std::vector<std::vector<double>> column_data(features, std::vector<double>(n));
+    std::vector<const double*> columns(features);
+    for (size_t f = 0; f < features; ++f) {
+        for (size_t i = 0; i < n; ++i) column_data[f][i] = rows[i * features + f];
+        columns[f] = column_data[f].data();
+    }
+
+    std::vector<double> single(n), batch(n);
+    SOMBatchOutput out;
+    out.expectancy = batch.data();
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) single[i] = som.getPrediction(&rows[i * features], features).expectancy;
+    auto t1 = std::chrono::steady_clock::now();
+    double single_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    std::cout << "batch " << width << "x" << height << " features=" << features
+              << " | getPrediction " << single_ns << " ns/row";
+
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads : {1u, cpus}) {
+        for (bool columnar : {false, true}) {
+            std::fill(batch.begin(), batch.end(), 0.0);
+            auto b0 = std::chrono::steady_clock::now();
+            if (columnar) som.getPredictions(columns.data(), features, n, out, threads);
+            else som.getPredictions(rows.data(), n, features, out, threads);
+            auto b1 = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(b1 - b0).count() / n;
+            size_t mismatch = 0;
+            for (size_t i = 0; i < n; ++i) mismatch += single[i] != batch[i];
+            std::cout << " | " << (columnar ? "columnar" : "rows") << " x" << threads << " " << ns
+                      << " ns/row (x" << single_ns / ns << ", mismatch " << mismatch << ")";
+        }
+        if (cpus == 1) break;
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main() {
+    run(20, 20, 7);   // 本番の 20x20 グリッド・7特徴量
+    run(20, 20, 4);
+    run(40, 40, 7);
+    run(64, 64, 7);
+    run(40, 40, 16);
+    run(20, 20, 11);  // 特化版の無い stride（12）
+
+    for (double step : {0.001, 0.01, 0.05}) {
+        run_coherent(20, 20, 7, step);
+        run_coherent(64, 64, 7, step);
+    }
+
+    run_batch(20, 20, 7);
+    run_batch(64, 64, 7);
+    return 0;
+}
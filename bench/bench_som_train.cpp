@@ -0,0 +1,213 @@
+// SOM の学習時間のベンチマーク
+// 一時ディレクトリに合成した市場データ（data/SYMBOL_features.bin）を作り、SOMTrainer で学習する時間を測る。
+// 1行ずつの学習（train_som.py と同じ）のあと、バッチSOMを1スレッドと全スレッドで測る。
+// 続けて、1つ前の窓で学習したモデルから始める warm start を、データから始める学習とエポックごとの量子化誤差で比べ、
+// 重みはそのままで期待値とリスクだけを付け直す時間を測る。
+// Python と train_som.py のパスを渡すと、同じデータで train_som.py も走らせて時間と量子化誤差を比べる
+// （train_som.py は最新30,000行しか使わないので、比べるときは rows を30,000以下にする）。
+//
+//   bench_som_train [rows] [python train_som.py]
+//   例: bench_som_train 30000 .venv/bin/python train_som.py
+#include "../FeatureStore.h"
+#include "../SOMModelFile.h"
+#include "../SOMTrainer.h"
+#include "../WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const std::string TARGET = "ETHUSDT";
+const std::string BTC = "BTCUSDT";
+
+// 1秒1行の合成データ。価格はランダムウォークで、インバランスが少し先の値動きに効く
+void write_market(const std::string& data_dir, const std::string& symbol, size_t rows, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    FeatureStoreWriter writer;
+    writer.open(data_dir + "/" + symbol + "_features.bin", symbol, rows + 1);
+    double price = 2000.0, imbalance = 0.0, vol = 0.001;
+    for (size_t i = 0; i < rows; ++i) {
+        double next = std::tanh(0.9 * imbalance + 0.3 * noise(rng));
+        double change = next - imbalance;
+        imbalance = next;
+        vol = 0.95 * vol + 0.05 * std::abs(0.001 * noise(rng));
+        price *= 1.0 + 0.0002 * imbalance + vol * noise(rng);
+        FeatureRow row = {1.7e9 + static_cast<double>(i), imbalance, change, 50.0 + 10.0 * std::abs(noise(rng)),
+                          price, price, vol, std::tanh(0.5 + 0.3 * noise(rng))};
+        writer.append(row);
+    }
+    writer.flush();
+}
+
+// スケーリング済みの各行から BMU までのユークリッド距離の平均
+double quantization_error(const SOMModel& model, const SOMTrainingSet& data) {
+    std::vector<double> x(model.stride);
+    double total = 0.0;
+    for (size_t i = 0; i < data.rows(); ++i) {
+        model.scale(&data.features[i * data.feature_count], x.data());
+        double best = 1e300;
+        for (size_t n = 0; n < model.node_count; ++n) {
+            double d = 0.0;
+            for (size_t f = 0; f < model.feature_count; ++f) {
+                double diff = model.weights[n * model.stride + f] - x[f];
+                d += diff * diff;
+            }
+            best = std::min(best, d);
+        }
+        total += std::sqrt(best);
+    }
+    return total / data.rows();
+}
+
+SOMTrainingSet slice(const SOMTrainingSet& data, size_t begin, size_t end) {
+    SOMTrainingSet out;
+    out.feature_count = data.feature_count;
+    out.features.assign(data.features.begin() + begin * data.feature_count,
+                        data.features.begin() + end * data.feature_count);
+    out.labels.assign(data.labels.begin() + begin, data.labels.begin() + end);
+    return out;
+}
+
+// 2つのモデルで BMU が同じノードになる行の割合（ノード番号の意味が保たれているか）
+double same_bmu_rate(const SOMModel& a, const SOMModel& b, const SOMTrainingSet& data) {
+    alignas(64) double xa[SOMModel::MAX_FEATURES], xb[SOMModel::MAX_FEATURES];
+    size_t same = 0;
+    for (size_t i = 0; i < data.rows(); ++i) {
+        a.scale(&data.features[i * data.feature_count], xa);
+        b.scale(&data.features[i * data.feature_count], xb);
+        same += a.find_bmu(xa) == b.find_bmu(xb);
+    }
+    return 100.0 * same / data.rows();
+}
+
+void print_errors(const char* label, const SOMTrainingReport& report) {
+    std::cout << "  " << label << " (" << report.train_seconds << " s):";
+    for (double qe : report.quantization_error) std::cout << " " << qe;
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 30000;
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "bench_som_train";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "data");
+    fs::create_directories(dir / "models");
+    const std::string data_dir = (dir / "data").string();
+
+    // 1つ前の窓（warm start の元にするモデル用）と今回の窓の2つ分を書く
+    SOMTrainingOptions options;
+    options.train_rows = 2 * rows;
+    options.seed = 1;
+    write_market(data_dir, TARGET, 2 * rows + options.future_rows + 60, 3);
+    write_market(data_dir, BTC, 2 * rows + options.future_rows + 60, 5);
+
+    SOMTrainingSet both;
+    auto l0 = std::chrono::steady_clock::now();
+    if (!load_training_set(data_dir, TARGET, BTC, options, both)) return 1;
+    double load_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - l0).count();
+    options.train_rows = rows;
+    rows = std::min(rows, both.rows() / 2);
+    SOMTrainingSet previous = slice(both, both.rows() - 2 * rows, both.rows() - rows);
+    SOMTrainingSet data = slice(both, both.rows() - rows, both.rows());
+
+    WorkerPool pool;
+    SOMModel native;
+    SOMTrainingReport report;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!train_som(data, options, pool, native, &report)) return 1;
+    double native_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "native: " << report.rows << " rows, " << options.grid_width << "x" << options.grid_height
+              << ", " << options.epochs << " epochs | load " << load_s << " s | train " << report.train_seconds
+              << " s | labels " << report.label_seconds << " s (" << pool.slots() << " threads) | total "
+              << native_s << " s | quantization error " << quantization_error(native, data) << std::endl;
+
+    // バッチSOM（ワーカー0人 = 呼び出し元だけ、と全CPU）
+    SOMTrainingOptions batch = options;
+    batch.mode = SOMTrainingMode::Batch;
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    double single_s = 0.0;
+    for (unsigned workers : {0u, cpus - 1}) {
+        WorkerPool batch_pool(workers);
+        SOMModel model;
+        if (!train_som(data, batch, batch_pool, model, &report)) return 1;
+        if (workers == 0) single_s = report.train_seconds;
+        std::cout << "batch: " << batch_pool.slots() << " threads | train " << report.train_seconds << " s (x"
+                  << single_s / report.train_seconds << " vs 1 thread, x" << native_s / report.train_seconds
+                  << " vs online) | labels " << report.label_seconds << " s | quantization error "
+                  << quantization_error(model, data) << std::endl;
+        if (cpus == 1) break;
+    }
+
+    // warm start: 1つ前の窓のモデルから短いスケジュールで学習する
+    {
+        SOMTrainingOptions cold = options;
+        cold.track_error = true;
+        SOMModel deployed, cold_model, warm_model;
+        SOMTrainingReport cold_report, warm_report;
+        if (!train_som(previous, options, pool, deployed)) return 1;
+        if (!train_som(data, cold, pool, cold_model, &cold_report)) return 1;
+        SOMTrainingOptions warm = cold;
+        warm.warm_start = true;
+        if (!train_som(data, warm, pool, warm_model, &warm_report, &deployed)) return 1;
+
+        // データから始めた学習の最後の誤差の1%以内に入るまでのエポック数
+        double target = cold_report.quantization_error.back() * 1.01;
+        auto epochs_to = [target](const SOMTrainingReport& r) {
+            for (size_t e = 0; e < r.quantization_error.size(); ++e) {
+                if (r.quantization_error[e] <= target) return static_cast<long>(e);
+            }
+            return -1L;
+        };
+        std::cout << "warm start: " << warm.warm_epochs << " epochs (sigma " << warm.warm_sigma << ") vs cold "
+                  << cold.epochs << " epochs (sigma " << cold.sigma << ") | epochs to within 1% of cold final: cold "
+                  << epochs_to(cold_report) << ", warm " << epochs_to(warm_report)
+                  << " | same BMU as the previous model: cold " << same_bmu_rate(deployed, cold_model, data)
+                  << "%, warm " << same_bmu_rate(deployed, warm_model, data) << "%" << std::endl;
+        print_errors("cold quantization error by epoch", cold_report);
+        print_errors("warm quantization error by epoch", warm_report);
+    }
+
+    // 付け直し: 重みはそのままで、最新の一部の行から期待値とリスクだけを計算し直す（全学習のラベル計算と比べる）
+    {
+        SOMTrainingSet recent = slice(data, data.rows() - std::max<size_t>(1, data.rows() / 8), data.rows());
+        std::vector<double> expectancy, risk;
+        for (SOMTrainingSet* set : {&data, &recent}) {
+            SOMRelabelReport relabel;
+            if (!relabel_som(*set, native, pool, expectancy, risk, &relabel)) return 1;
+            std::cout << "relabel: " << relabel.rows << " rows, " << relabel.nodes << "/" << native.node_count
+                      << " nodes in " << relabel.seconds * 1000.0 << " ms (x" << native_s / relabel.seconds
+                      << " faster than a full retrain)" << std::endl;
+        }
+    }
+
+    if (argc > 3) {
+        // train_som.py は作業ディレクトリの data/ と models/ を使う
+        std::string script = fs::absolute(argv[3]).string();
+        std::string cmd = "cd \"" + dir.string() + "\" && \"" + argv[2] + "\" \"" + script + "\" " + TARGET +
+                          " > python.log 2>&1";
+        auto p0 = std::chrono::steady_clock::now();
+        int result = std::system(cmd.c_str());
+        double python_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - p0).count();
+        SOMModel python;
+        if (result != 0 || !load_som_model(som_model_path((dir / "models").string(), TARGET), python)) {
+            std::cerr << "train_som.py failed (see " << (dir / "python.log").string() << ")" << std::endl;
+            return 1;
+        }
+        std::cout << "python: total " << python_s << " s (x" << python_s / native_s << " slower)"
+                  << " | quantization error " << quantization_error(python, data) << std::endl;
+    }
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,96 @@
+// ボラティリティ計算のベンチマーク
+// 旧実装（deque を毎ティック2回走査）と RollingWindow（差分更新）の1ティックあたりの時間と、
+// 結果の最大相対誤差を比較する
+#include "../RollingWindow.h"
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 旧 calculate_volatility と同じ計算
+double volatility_deque(const std::deque<double>& prices) {
+    if (prices.size() < 2) return 0.0;
+    double sum = std::accumulate(prices.begin(), prices.end(), 0.0);
+    double mean = sum / prices.size();
+    double sq_sum = 0;
+    for (double p : prices) sq_sum += (p - mean) * (p - mean);
+    return std::sqrt(sq_sum / prices.size()) / mean;
+}
+
+double volatility_rolling(const RollingWindow& prices) {
+    if (prices.size() < 2) return 0.0;
+    return prices.stddev() / prices.mean();
+}
+
+std::vector<double> random_walk(double start, size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> step(0.0, start * 0.00005);
+    std::vector<double> prices(n);
+    double p = start;
+    for (auto& x : prices) {
+        p += step(rng);
+        x = p;
+    }
+    return prices;
+}
+
+void run(double start_price, size_t window) {
+    const size_t n = 2000000;
+    auto prices = random_walk(start_price, n, 42);
+
+    // 結果の一致を確認
+    std::deque<double> dq;
+    RollingWindow rw(window);
+    double max_rel = 0.0;
+    for (double p : prices) {
+        dq.push_back(p);
+        if (dq.size() > window) dq.pop_front();
+        rw.push(p);
+        double a = volatility_deque(dq), b = volatility_rolling(rw);
+        if (a > 0.0) max_rel = std::max(max_rel, std::abs(a - b) / a);
+    }
+
+    double sink = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        std::deque<double> d;
+        for (double p : prices) {
+            d.push_back(p);
+            if (d.size() > window) d.pop_front();
+            sink += volatility_deque(d);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    {
+        RollingWindow r(window);
+        for (double p : prices) {
+            r.push(p);
+            sink += volatility_rolling(r);
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double deque_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double rolling_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+    std::cout << "price~" << start_price << " window=" << window
+              << " | deque " << deque_ns << " ns/tick"
+              << " | rolling " << rolling_ns << " ns/tick"
+              << " | speedup " << deque_ns / rolling_ns << "x"
+              << " | max rel diff " << max_rel
+              << " (checksum " << sink << ")" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    for (size_t window : {60, 600}) {
+        run(5.0, window);      // ATOM 程度
+        run(60000.0, window);  // BTC 程度
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""
+特徴量ファイル（data/SYMBOL/YYYYMMDD[HH]_features.bin）の読み込み
+C++ の MarketRecorder が CSV と同じ行を列形式で書いている（形式は FeatureStore.h 参照）。
+numpy.memmap でそのまま開くので解析は不要で、末尾N行はオフセット計算だけで取り出せる。
+ファイルは時間で区切られていて、data/SYMBOL/manifest.csv を見て必要なパーティションだけを開く
+（区切る前の data/SYMBOL_features.bin は最も古いパーティションとして扱う。MarketDataStore.h 参照）。
+特徴量ファイルより前から書いていた data/SYMBOL_market_data.csv の方が行が多ければ、
+最も古いパーティションとしてそちらを読む（C++ が起動時に features.bin へ写す前でも履歴を捨てないため）。
+
+使い方:
+    import feature_store
+    df = feature_store.read_symbol_tail("data", "ETHUSDT", 30000)
+    df = feature_store.read_symbol_range("data", "BTCUSDT", t0, t1)
+"""
+
+import os
+import struct
+
+import numpy as np
+import pandas as pd
+
+MAGIC = b"MMFEAT\0\0"
+VERSION = 1
+DTYPE_F64 = 1
+NAME_SIZE = 32
+
+# data/SYMBOL_market_data.csv の列（ヘッダー行あり）
+CSV_COLUMNS = ['timestamp', 'symbol', 'imbalance', 'imbalance_change', 'total_depth',
+               'price', 'btc_price', 'volatility', 'btc_pearson']
+
+# magic, version, header_size, column_count, dtype, capacity, row_count, symbol
+_HEADER = struct.Struct("<8sIIIIQQ24s")
+# 写した元の CSV の大きさ・更新時刻（backfill_legacy_features）
+_SOURCE_STAMP = struct.Struct("<Qq")
+SOURCE_STAMP_OFFSET = 4032
+
+
+class FeatureStore:
+    """1銘柄の特徴量ファイル。columns は列名 → 長さ row_count の読み取り専用 memmap"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            head = f.read(_HEADER.size)
+            (magic, version, header_size, column_count, dtype,
+             capacity, row_count, symbol) = _HEADER.unpack(head)
+            if magic != MAGIC or version != VERSION or dtype != DTYPE_F64:
+                raise ValueError(f"unsupported feature store: {path}")
+            names_raw = f.read(NAME_SIZE * column_count)
+            f.seek(SOURCE_STAMP_OFFSET)
+            source_size, _ = _SOURCE_STAMP.unpack(f.read(_SOURCE_STAMP.size))
+
+        self.path = path
+        self.symbol = symbol.split(b"\0", 1)[0].decode()
+        self.capacity = capacity
+        self.source_size = source_size
+        self.row_count = min(row_count, capacity)
+        self.names = [names_raw[i * NAME_SIZE:(i + 1) * NAME_SIZE].split(b"\0", 1)[0].decode()
+                      for i in range(column_count)]
+
+        data = np.memmap(path, dtype="<f8", mode="r", offset=header_size,
+                         shape=(column_count, capacity))
+        self.columns = {name: data[i, :self.row_count] for i, name in enumerate(self.names)}
+
+    def __len__(self):
+        return self.row_count
+
+    def frame(self, start, stop):
+        """行 [start, stop) を CSV と同じ列の DataFrame にする（この範囲だけをコピーする）"""
+        df = pd.DataFrame({name: np.array(col[start:stop]) for name, col in self.columns.items()})
+        df["timestamp"] = df["timestamp"].astype(np.int64)
+        df.insert(1, "symbol", self.symbol)
+        return df
+
+
+def read_tail(path, n):
+    """末尾 n 行"""
+    store = FeatureStore(path)
+    return store.frame(max(0, len(store) - n), len(store))
+
+
+def read_range(path, t0, t1):
+    """timestamp が [t0, t1] の行（timestamp は書き込み順に単調増加）"""
+    store = FeatureStore(path)
+    ts = store.columns["timestamp"]
+    start = int(np.searchsorted(ts, t0, side="left"))
+    stop = int(np.searchsorted(ts, t1, side="right"))
+    return store.frame(start, stop)
+
+
+def _concat(frames):
+    frames = [f for f in frames if len(f) > 0]
+    if not frames:
+        return pd.DataFrame(columns=["timestamp", "symbol"])
+    return pd.concat(frames, ignore_index=True)
+
+
+def load_manifest(data_dir, symbol):
+    """パーティション一覧（古い順）。manifest が無ければ空"""
+    path = os.path.join(data_dir, symbol, "manifest.csv")
+    if not os.path.exists(path):
+        return []
+    df = pd.read_csv(path, dtype={"partition": str})
+    return df.sort_values("partition").to_dict("records")
+
+
+def _feature_files(data_dir, symbol, partitions):
+    files = []
+    legacy = os.path.join(data_dir, f"{symbol}_features.bin")
+    if os.path.exists(legacy):
+        files.append((legacy, None))
+    for p in partitions:
+        files.append((os.path.join(data_dir, symbol, f"{p['partition']}_features.bin"), p))
+    return [(path, p) for path, p in files if os.path.exists(path)]
+
+
+def _partition_files(data_dir, symbol, partitions):
+    return [(path, p) for path, p in _feature_files(data_dir, symbol, partitions) if p is not None]
+
+
+def _count_lines(path):
+    with open(path, "rb") as f:
+        return sum(chunk.count(b"\n") for chunk in iter(lambda: f.read(1 << 16), b""))
+
+
+def _legacy_paths(data_dir, symbol):
+    return (os.path.join(data_dir, f"{symbol}_market_data.csv"),
+            os.path.join(data_dir, f"{symbol}_features.bin"))
+
+
+def _legacy_csv_is_longer(csv_path, bin_path):
+    """区切る前の CSV に features.bin より多くの行があるか。
+    C++ が写したときの CSV の大きさがヘッダーに残っていて、今の大きさと同じなら数えずに False"""
+    if not os.path.exists(csv_path):
+        return False
+    if not os.path.exists(bin_path):
+        return True
+    store = FeatureStore(bin_path)
+    if store.source_size == os.path.getsize(csv_path):
+        return False
+    return _count_lines(csv_path) - 1 > len(store)
+
+
+def _read_legacy_csv(csv_path):
+    df = pd.read_csv(csv_path, names=CSV_COLUMNS, header=0)
+    df["timestamp"] = pd.to_numeric(df["timestamp"], errors="coerce")
+    df = df.dropna(subset=["timestamp"])
+    df["timestamp"] = df["timestamp"].astype(np.int64)
+    return df.sort_values("timestamp", kind="stable").reset_index(drop=True)
+
+
+def read_legacy_tail(data_dir, symbol, n):
+    """区切る前の履歴の末尾 n 行。features.bin より CSV の方が行が多ければ CSV を読む"""
+    csv_path, bin_path = _legacy_paths(data_dir, symbol)
+    if _legacy_csv_is_longer(csv_path, bin_path):
+        df = _read_legacy_csv(csv_path)
+        return df.iloc[max(0, len(df) - n):]
+    if os.path.exists(bin_path):
+        return read_tail(bin_path, n)
+    return _concat([])
+
+
+def read_legacy_range(data_dir, symbol, t0, t1):
+    """区切る前の履歴のうち timestamp が [t0, t1] の行"""
+    csv_path, bin_path = _legacy_paths(data_dir, symbol)
+    if _legacy_csv_is_longer(csv_path, bin_path):
+        df = _read_legacy_csv(csv_path)
+        return df[(df["timestamp"] >= t0) & (df["timestamp"] <= t1)]
+    if os.path.exists(bin_path):
+        return read_range(bin_path, t0, t1)
+    return _concat([])
+
+
+def has_features(data_dir, symbol):
+    return len(_feature_files(data_dir, symbol, load_manifest(data_dir, symbol))) > 0
+
+
+def read_symbol_tail(data_dir, symbol, n):
+    """最新の n 行（古い順）。新しいパーティションから順に、足りるまでしか開かない"""
+    frames = []
+    remaining = n
+    for path, _ in reversed(_partition_files(data_dir, symbol, load_manifest(data_dir, symbol))):
+        if remaining <= 0:
+            break
+        store = FeatureStore(path)
+        take = min(len(store), remaining)
+        frames.append(store.frame(len(store) - take, len(store)))
+        remaining -= take
+    if remaining > 0:
+        frames.append(read_legacy_tail(data_dir, symbol, remaining))
+    return _concat(list(reversed(frames)))
+
+
+def read_symbol_range(data_dir, symbol, t0, t1):
+    """timestamp が [t0, t1] の行（古い順）。範囲に重なるパーティションだけを開く"""
+    partitions = load_manifest(data_dir, symbol)
+    newest = partitions[-1]["partition"] if partitions else None
+    frames = [read_legacy_range(data_dir, symbol, t0, t1)]  # 範囲が分からないので常に見る
+    for path, p in _partition_files(data_dir, symbol, partitions):
+        # 書き込み中のパーティションは manifest の last_ts が遅れているので上限は見ない
+        if p["first_ts"] > t1 or (p["partition"] != newest and p["last_ts"] < t0):
+            continue
+        frames.append(read_range(path, t0, t1))
+    return _concat(frames)
@@ -1,14 +1,25 @@
 #include "ScanMarket.h"
 #include "SOMEvaluator.h"
 #include "ExecuteTrade.h"
+#include "BookTicker.h"
+#include "SymbolRegistry.h"
+#include "TickPipeline.h"
+#include "MarketShard.h"
+#include "SharedBoard.h"
+#include "AppConfig.h"
+#include "LatencyHistogram.h"
+#include "MarketRecorder.h"
+#include "SOMModelFile.h"
+#include "SOMOnlineLearner.h"
+#include "SOMTrainer.h"
+#include "WorkerPool.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
-#include <map>
 #include <string>
-#include <nlohmann/json.hpp>
-#include <ixwebsocket/IXWebSocket.h>
 #include <vector>
+#include <atomic>
+#include <memory>
 #include <algorithm>
 #include <mutex>
 #include <filesystem>
@@ -20,8 +31,6 @@
 #pragma comment(lib, "ws2_32.lib")
 #endif
 
-using json = nlohmann::json;
-
 void initialize_files() {
     // 開発時時間がかかるのでいったんコメントアウト　必要に応じて再度有効化
     // data フォルダの CSV 削除
@@ -38,18 +47,99 @@ void initialize_files() {
     //}
     std::cout << "Logs and previous models cleared." << std::endl;
 }
-int count_csv_lines(std::string filename) {
-    if (!std::filesystem::exists(filename)) return 0;
-    try {
-        std::ifstream file(filename);
-        if (!file.is_open()) return 0;
-        return std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    } catch (...) {
-        return 0; // ファイルが使用中の場合は 0 を返して次のループで再トライ
+
+// SOMへ渡す特徴量の数（トレードループの features と train_som.py の features の並び）
+constexpr size_t SOM_FEATURE_COUNT = 7;
+
+// models/SYMBOL_som.bin があればそれを、無ければ従来の4つのCSVを読む
+bool load_symbol_model(SOMEvaluator& som, const std::string& symbol) {
+    std::string model_path = som_model_path("models", symbol);
+    bool loaded = false;
+    if (std::filesystem::exists(model_path)) {
+        loaded = som.loadModelFile(model_path);
+    } else {
+        std::string prefix = "models/" + symbol + "_";
+        loaded = som.loadModel(
+            prefix + "map_weights.csv",
+            prefix + "expectancy.csv",
+            prefix + "scaling_params.csv",
+            prefix + "risk_map.csv"
+        );
+    }
+    if (!loaded) return false;
+
+    SOMShape shape = som.shape();
+    std::cout << "[SOM] " << symbol << ": " << shape.grid_width << "x" << shape.grid_height
+              << " grid, " << shape.feature_count << " features, kernel " << shape.kernel << std::endl;
+    if (shape.feature_count != SOM_FEATURE_COUNT) {
+        std::cerr << "[SOM] " << symbol << ": model expects " << shape.feature_count << " features but "
+                  << SOM_FEATURE_COUNT << " are provided; predictions fall back to neutral" << std::endl;
+    }
+    return true;
+}
+
+// --trainer python のときに呼ぶ学習スクリプト
+const std::string PYTHON_TRAIN_COMMAND =
+    "C:\\Users\\MichihikoKubota\\Documents\\My-MM\\.venv\\Scripts\\python.exe train_som.py ";
+
+// symbol を学習し直して som を差し替える（失敗したら前のモデルのまま）
+// native はプロセス内で学習して models/SYMBOL_som.bin に保存し、読み直さずにそのまま差し替える
+bool train_symbol(SOMEvaluator& som, const std::string& symbol, const AppConfig& config, WorkerPool& pool) {
+    if (config.trainer == TrainerKind::Python) {
+        std::string cmd = PYTHON_TRAIN_COMMAND + symbol;
+        if (std::system(cmd.c_str()) != 0) return false;
+        return load_symbol_model(som, symbol);
+    }
+
+    SOMTrainingSet data;
+    if (!load_training_set(config.recorder.directory, symbol, config.btc_symbol, config.training, data)) {
+        return false;
+    }
+    // 公開中のモデル（オンライン学習で直した分も含む）の重みから始める
+    SOMModel deployed;
+    std::uint64_t generation = 0;
+    bool has_deployed = config.training.warm_start && som.snapshot(deployed, generation);
+    auto model = std::make_unique<SOMModel>();
+    SOMTrainingReport report;
+    if (!train_som(data, config.training, pool, *model, &report, has_deployed ? &deployed : nullptr)) return false;
+    if (!save_som_model(som_model_path("models", symbol), *model, symbol)) {
+        std::cerr << "[SOM] " << symbol << ": failed to save the trained model" << std::endl;
+    }
+    std::cout << "[SOM] " << symbol << ": trained " << model->grid_width << "x" << model->grid_height
+              << " on " << report.rows << " rows in " << report.train_seconds << " s (labels "
+              << report.label_seconds << " s)" << (report.warm_started ? " from the deployed weights" : "")
+              << std::endl;
+    if (!report.quantization_error.empty()) {
+        std::cout << "[SOM] " << symbol << ": quantization error by epoch";
+        for (double qe : report.quantization_error) std::cout << " " << qe;
+        std::cout << std::endl;
     }
+    som.publish(std::move(model));
+    return true;
 }
 
-int main() {
+// 公開中のモデルの重みはそのままで、最新 relabel_rows 行から期待値とリスクだけを付け直す
+bool relabel_symbol(SOMEvaluator& som, const std::string& symbol, const AppConfig& config, WorkerPool& pool) {
+    SOMModel deployed;
+    std::uint64_t generation = 0;
+    if (!som.snapshot(deployed, generation)) return false;
+    SOMTrainingOptions options = config.training;
+    options.train_rows = config.relabel_rows;
+    options.min_rows = std::min(options.min_rows, config.relabel_rows);
+    SOMTrainingSet data;
+    if (!load_training_set(config.recorder.directory, symbol, config.btc_symbol, options, data)) return false;
+    std::vector<double> expectancy, risk;
+    SOMRelabelReport report;
+    if (!relabel_som(data, deployed, pool, expectancy, risk, &report)) return false;
+    // 付け直している間に再学習やオンライン学習のモデルが公開されていたら、今回は見送る
+    return som.relabel(expectancy, risk, generation);
+}
+
+int main(int argc, char* argv[]) {
+    // 銘柄・接続数・接続先URLなどの設定（AppConfig.h 参照）
+    AppConfig config;
+    if (!parse_app_config(argc, argv, config)) return 1;
+
     // windows socketの初期化
     #ifdef _WIN32
         WSADATA wsaData;
@@ -63,190 +153,286 @@ int main() {
     std::filesystem::create_directories("models");
 
     // 銘柄リスト
-    std::vector<std::string> symbols = {"ATOMUSDT", "ETHUSDT", "SOLUSDT", "BTCUSDT"};
-    std::string btc_symbol = "BTCUSDT";
+    const std::vector<std::string>& symbols = config.symbols;
+    const std::string& btc_symbol = config.btc_symbol;
+
+    // 銘柄名 → 連番ID。以降の銘柄ごとの状態はすべてこのIDで引く配列に置く
+    SymbolRegistry registry;
+    for (const auto& symbol : symbols) registry.add(symbol);
+    SymbolId btc_id = registry.add(btc_symbol);
+    registry.set_reference(btc_id);
+    init_market_history(registry.size(), config.windows);
+    init_trade_state(registry.size());
     
     // 銘柄の相場情報
-    std::map<std::string, double> prices;
-    std::map<std::string, MarketState> market_state;
+    // market_state[id] はその銘柄を担当するシャードだけが書く。
+    // 他のシャードから見える値（BTCの価格・インバランスなど）は board 経由で読む
+    std::vector<MarketState> market_state(registry.size());
+    SharedBoard board(registry.size());
     
-    // 仮想トレード管理
+    // 仮想トレード管理（全シャードで共有するので trade_mutex で守る）
     std::vector<TradeData> active_trades;
-    
-    std::mutex price_mutex;
+    std::mutex trade_mutex;
     
     // .csv初期化
     initialize_files();
     // SOMモデル読み込み
-    std::map<std::string, SOMEvaluator> som_models;
+    std::vector<SOMEvaluator> som_models(registry.size());
+    for (auto& som : som_models) som.setSearch(config.som_search);
     for (const auto& symbol : symbols) {
-        std::string prefix = "models/" + symbol + "_";
-        som_models[symbol].loadModel(
-            prefix + "map_weights.csv",
-            prefix + "expectancy.csv",
-            prefix + "scaling_params.csv",
-            prefix + "risk_map.csv"
-        );
+        load_symbol_model(som_models[registry.find(symbol)], symbol);
     }
 
-    // WebSocket 接続
-    ix::WebSocket webSocket;
-    std::string url = "wss://stream.binance.com/stream?streams="; // ポート9443を外し、/streamを明示
-    
-    for (size_t i = 0; i < symbols.size(); ++i) {
-        std::string lower_symbol = symbols[i];
-        std::transform(lower_symbol.begin(), lower_symbol.end(), lower_symbol.begin(), ::tolower);
-        url += lower_symbol + "@bookTicker";
-        if (i < symbols.size() - 1) {
-            url += "/";
-        }
-    }
-    
-    webSocket.setUrl(url);
     // トレード開始フラグ
-    bool trading_enabled = false;
-    // WebSocket メッセージ受信
-    webSocket.setOnMessageCallback([&](const ix::WebSocketMessagePtr& msg) {
-        if (msg->type == ix::WebSocketMessageType::Message) {
-            try {
-                auto root = json::parse(msg->str);
-                auto data = root.count("data") ? root["data"] : root;
-                
-                if (!data.contains("s")) {
-                    return;
-                }
-                
-                std::string symbol = data["s"];
-                double bid_price = std::stod(data["b"].get<std::string>());
-                double ask_price = std::stod(data["a"].get<std::string>());
-                double bid_volume = std::stod(data["B"].get<std::string>());
-                double ask_volume = std::stod(data["A"].get<std::string>());
-                
-                double mid_price = (bid_price + ask_price) / 2.0;
-                double imbalance = (bid_volume - ask_volume) / (bid_volume + ask_volume);
-                
-                // 板の総厚みを計算
-                double total_depth = bid_volume + ask_volume;
+    std::atomic<bool> trading_enabled{false};
+    // ストラテジースレッドでのティック処理（指標計算 → SOM予測 → 発注判定）
+    // imbalance_change は常に「前回処理した板」との差なので、間引き時も正しく計算される
+    // 全シャードのストラテジースレッドから並行して呼ばれる（担当銘柄は重ならない）
+    // latency はそのシャード専用のヒストグラム（書き手はこのスレッドだけ）
+    // records はそのシャード専用のレコーダーのキュー
+    auto on_quote = [&](const BookQuote& tick, TickLatency& latency, MarketRecorder::Lane& records) {
+        SymbolId id = tick.id;
+        double mid_price = (tick.bid_price + tick.ask_price) / 2.0;
+        double imbalance = (tick.bid_volume - tick.ask_volume) / (tick.bid_volume + tick.ask_volume);
+        
+        // 板の総厚みを計算
+        double total_depth = tick.bid_volume + tick.ask_volume;
 
-                {
-                    std::lock_guard<std::mutex> lock(price_mutex);
-    
-                    prices[symbol] = mid_price;
+        MarketState& state = market_state[id];
 
-                    // インバランスの変化を計算（初回は0.0）
-                    double imbalance_change = market_state.count(symbol) ? imbalance - market_state[symbol].imbalance : 0.0;
+        // インバランスの変化を計算（初回は0.0）
+        double imbalance_change = state.has_data ? imbalance - state.imbalance : 0.0;
+        board.publish(id, mid_price, imbalance, imbalance_change, tick.recv_ns);
 
-                    // 計算とCSV保存を実行
-                    double btc_price = prices.count(btc_symbol) ? prices[btc_symbol] : mid_price;
-                    process_ws_data(symbol, imbalance, imbalance_change, total_depth, mid_price, btc_price, market_state);
-                    
-                    // トレード開始時刻を過ぎていたらトレード判定を行う
-                    if (trading_enabled && prices.count(symbol) && prices.count(btc_symbol)) {
-                        // SOMへの入力
-                        std::vector<double> features = {
-                            market_state[symbol].imbalance,
-                            market_state[symbol].diff,
-                            market_state[btc_symbol].imbalance,
-                            market_state[btc_symbol].diff,
-                            market_state[symbol].total_depth,
-                            market_state[symbol].volatility,
-                            market_state[symbol].btc_corr
-                        };
-                        
-                        SOMResult result = som_models[symbol].getPrediction(features);
-                        execute_trade(result.expectancy, mid_price, symbol, active_trades, market_state[symbol].imbalance, market_state[symbol]);
-                    }
-                }
-            } catch (const std::exception& e) {
-                // Error
+        // 計算とCSV保存を実行
+        double btc_price = board.mid_price(btc_id);
+        if (btc_price <= 0.0) btc_price = mid_price;
+        process_ws_data(id, imbalance, imbalance_change, total_depth, mid_price, btc_price,
+                        tick.recv_ns, &records, market_state);
+        std::int64_t processed_ns = monotonic_ns();
+        latency.parse.record(tick.parsed_ns - tick.recv_ns);
+        latency.process.record(processed_ns - tick.parsed_ns);
+        
+        // トレード開始時刻を過ぎていたらトレード判定を行う
+        if (trading_enabled.load(std::memory_order_acquire) && board.mid_price(btc_id) > 0.0) {
+            // SOMへの入力
+            const double features[SOM_FEATURE_COUNT] = {
+                state.imbalance,
+                state.diff,
+                board.imbalance(btc_id),
+                board.diff(btc_id),
+                state.total_depth,
+                state.volatility,
+                state.btc_corr
+            };
+            
+            SOMResult result = som_models[id].getPrediction(features, SOM_FEATURE_COUNT);
+            std::int64_t predicted_ns = monotonic_ns();
+            {
+                std::lock_guard<std::mutex> lock(trade_mutex);
+                execute_trade(result.expectancy, mid_price, id, registry, active_trades, state.imbalance, state);
             }
+            std::int64_t executed_ns = monotonic_ns();
+            latency.predict.record(predicted_ns - processed_ns);
+            latency.execute.record(executed_ns - predicted_ns);
+            latency.total.record(executed_ns - tick.recv_ns);
         }
-    });
-    
-    webSocket.start();
-    std::cout << "Waiting for data to reach 500 lines..." << std::endl;
+    };
+    // レイテンシ計測（シャードごとに1組）と、価格受信 → SELL判定の計測
+    // （exit はメインループが書く。0.5秒おきの決済判定の待ち時間を含む）
+    std::vector<std::unique_ptr<TickLatency>> shard_latency;
+    LatencyHistogram exit_latency;
+
+    // オンライン学習はレコーダーが書いた行を受け取る（モデルが公開されるまでは読み捨てる）。
+    // レコーダーより先に作り、後に壊す
+    std::unique_ptr<SOMOnlineLearner> online_learner;
+    if (config.online_learning) {
+        online_learner = std::make_unique<SOMOnlineLearner>(registry, som_models, btc_id, config.online);
+    }
+    // 市場データCSVの書き込みスレッド（シャードごとにキューを1本）
+    MarketRecorder recorder(registry, static_cast<size_t>(config.shards), config.recorder);
+    if (online_learner) {
+        SOMOnlineLearner* learner = online_learner.get();
+        recorder.set_listener([learner](const MarketRecord& record) { learner->push(record); });
+        online_learner->start();
+    }
+    recorder.start();
+
+    // WebSocket 接続（銘柄を config.shards 本の接続に振り分ける）
+    TickPipeline::Mode mode = config.conflate ? TickPipeline::Mode::Conflate : TickPipeline::Mode::Queue;
+    unsigned cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<MarketShard>> shards;
+    for (auto& symbol_ids : partition_symbols(registry.size(), config.shards)) {
+        shard_latency.push_back(std::make_unique<TickLatency>());
+        TickLatency* latency = shard_latency.back().get();
+        MarketRecorder::Lane* records = &recorder.lane(shards.size());
+        shards.push_back(std::make_unique<MarketShard>(registry, std::move(symbol_ids), mode,
+            [&on_quote, latency, records](const BookQuote& tick) { on_quote(tick, *latency, *records); }));
+    }
+    for (size_t k = 0; k < shards.size(); ++k) {
+        int cpu = config.strategy_cpu < 0 ? -1 : static_cast<int>((config.strategy_cpu + k) % cpu_count);
+        shards[k]->start(config.stream_url, cpu);
+    }
+    std::cout << "Connected " << registry.size() << " symbols over " << shards.size()
+              << " stream(s) to " << config.stream_url << std::endl;
+
+    // 行数はレコーダーが数えている（起動時は manifest から）。全銘柄がそろった時点で起こされる
+    const std::uint64_t warmup_rows = 1500;
+    std::vector<SymbolId> warmup_ids;
+    for (const auto& symbol : symbols) warmup_ids.push_back(registry.find(symbol));
+    std::cout << "Waiting for data to reach " << warmup_rows << " lines..." << std::endl;
     while (true) {
         bool all_ready = true;
-        for (const auto& symbol : symbols) {
-            std::string filename = "data/" + symbol + "_market_data.csv";
-            int lines = count_csv_lines(filename);
-            if (lines < 1500) {
-                std::cout << "Waiting for " << symbol << ": " << lines << "/1500 lines collected." << std::endl;
+        for (SymbolId id : warmup_ids) {
+            std::uint64_t lines = recorder.rows(id);
+            if (lines < warmup_rows) {
+                std::cout << "Waiting for " << registry.name(id) << ": " << lines << "/" << warmup_rows
+                          << " lines collected." << std::endl;
                 all_ready = false;
             }
         }
         if (all_ready) break;
-        std::this_thread::sleep_for(std::chrono::seconds(60)); // 60秒おきにチェック
+        // 進み具合の表示は60秒おき
+        if (recorder.wait_for_rows(warmup_ids, warmup_rows, std::chrono::seconds(60))) break;
     }
+    // 学習用のワーカー（ストラテジースレッドの分は空けておく）。銘柄ごとの学習を並行に走らせ、
+    // 各学習の中の BMU の付け直しも同じプールで分ける
+    unsigned train_threads = cpu_count > static_cast<unsigned>(config.shards) + 1
+        ? cpu_count - static_cast<unsigned>(config.shards) - 1 : 1;
+    WorkerPool train_pool(train_threads);
+
     // 行数満たした後、初回の学習を実行
     std::cout << "Starting initial SOM training with collected data..." << std::endl;
-    for (const auto& symbol : symbols) {
-        std::cout << "Training " << symbol << "..." << std::endl;
-        std::string cmd = "C:\\Users\\MichihikoKubota\\Documents\\My-MM\\.venv\\Scripts\\python.exe train_som.py " + symbol;
-        int result = std::system(cmd.c_str());
-        
-        if (result == 0) {
-            std::lock_guard<std::mutex> lock(price_mutex);
-            std::string prefix = "models/" + symbol + "_";
-            bool success = som_models[symbol].loadModel(
-                prefix + "map_weights.csv",
-                prefix + "expectancy.csv",
-                prefix + "scaling_params.csv",
-                prefix + "risk_map.csv"
-            );
-            if (success) std::cout << "Model loaded for " << symbol << std::endl;
-        } else {
-            std::cerr << "Initial training failed for " << symbol << std::endl;
+    train_pool.parallel_for(symbols.size(), 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            const std::string& symbol = symbols[i];
+            std::cout << "Training " << symbol << "..." << std::endl;
+            if (train_symbol(som_models[registry.find(symbol)], symbol, config, train_pool)) {
+                std::cout << "Model loaded for " << symbol << std::endl;
+            } else {
+                std::cerr << "Initial training failed for " << symbol << std::endl;
+            }
         }
-    }
+    });
     // 初期学習が終わったのでフラグをONにする
-    {
-        std::lock_guard<std::mutex> lock(price_mutex); // 全コアに対しメモリの同期
-        trading_enabled = true;
-        std::cout << "Warm-up complete. Trading enabled!" << std::endl;
-    }
+    trading_enabled.store(true, std::memory_order_release);
+    std::cout << "Warm-up complete. Trading enabled!" << std::endl;
         
     // 30分ごとにSOM再学習
-    std::thread training_thread([&symbols, &som_models, &price_mutex]() {
+    std::thread training_thread([&symbols, &registry, &som_models, &config, &train_pool]() {
         while (true) {
             std::this_thread::sleep_for(std::chrono::minutes(30)); 
-            for (const auto& symbol : symbols) {
-                std::string cmd = "C:\\Users\\MichihikoKubota\\Documents\\My-MM\\.venv\\Scripts\\python.exe train_som.py " + symbol;
-                int result = std::system(cmd.c_str());
-                if (result == 0){
-                    std::lock_guard<std::mutex> lock(price_mutex); // 推論中に読み替えないようロック
-                    std::string prefix = "models/" + symbol + "_";
-                    bool success = som_models[symbol].loadModel(
-                        prefix + "map_weights.csv",
-                        prefix + "expectancy.csv",  
-                        prefix + "scaling_params.csv",
-                        prefix + "risk_map.csv"
-                    );
-                    if (success) {
-                        std::cout << "Model reloaded for " << symbol << std::endl;
-                        // グラフのために学習完了ログを追記
-                        std::ofstream train_log("data/training_events.csv", std::ios::app);
-                        if (train_log.is_open()) {
-                            long long ts = std::chrono::duration_cast<std::chrono::seconds>(
-                                std::chrono::system_clock::now().time_since_epoch()).count();
-                            train_log << ts << "," << symbol << "\n";
-                            train_log.close();
-                        }
-                    }
+            // 新しいモデルは組み立て終わってから差し替わる（推論は止まらず、失敗時は前のモデルのまま）
+            std::vector<char> trained(symbols.size(), 0);
+            train_pool.parallel_for(symbols.size(), 1, [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin; i < end; ++i) {
+                    trained[i] = train_symbol(som_models[registry.find(symbols[i])], symbols[i], config, train_pool);
+                }
+            });
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                if (!trained[i]) continue;
+                std::cout << "Model reloaded for " << symbols[i] << std::endl;
+                // グラフのために学習完了ログを追記
+                std::ofstream train_log("data/training_events.csv", std::ios::app);
+                if (train_log.is_open()) {
+                    long long ts = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                    train_log << ts << "," << symbols[i] << "\n";
+                    train_log.close();
                 }
             }
         }
     });
     training_thread.detach();
+
+    // 再学習の合間に、期待値とリスクだけを新しい行で付け直す（重みの学習はしないので数ミリ秒）
+    if (config.relabel_sec > 0) {
+        std::thread relabel_thread([&symbols, &registry, &som_models, &config, &train_pool]() {
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(config.relabel_sec));
+                auto t0 = std::chrono::steady_clock::now();
+                std::atomic<size_t> relabeled{0};
+                train_pool.parallel_for(symbols.size(), 1, [&](size_t begin, size_t end, size_t) {
+                    for (size_t i = begin; i < end; ++i) {
+                        if (relabel_symbol(som_models[registry.find(symbols[i])], symbols[i], config, train_pool)) {
+                            relabeled.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                });
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                std::cout << "[SOM] relabeled " << relabeled.load() << "/" << symbols.size() << " symbols on the latest "
+                          << config.relabel_rows << " rows in " << ms << " ms" << std::endl;
+            }
+        });
+        relabel_thread.detach();
+    }
     
     
     // メインループ
+    auto last_stats_time = std::chrono::steady_clock::now();
+    std::vector<double> prices;
+    std::vector<std::int64_t> price_recv_ns;
     while (true) {
         // 1500行ためるため、0.5秒おきに
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        board.snapshot_prices(prices, price_recv_ns);
         {
-            std::lock_guard<std::mutex> lock(price_mutex);
-            check_and_close_trades(active_trades, prices);
+            std::lock_guard<std::mutex> lock(trade_mutex);
+            check_and_close_trades(active_trades, prices, price_recv_ns, &exit_latency);
+        }
+
+        // パイプラインが受信に追いついているか・各段階の所要時間を、1分おきに表示
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_stats_time >= std::chrono::seconds(60)) {
+            last_stats_time = now;
+            for (size_t k = 0; k < shards.size(); ++k) {
+                TickPipeline::Stats st = shards[k]->stats();
+                std::cout << "[PIPELINE " << k << "] ring " << st.occupancy << "/" << st.capacity
+                          << " (max " << st.high_water << ")"
+                          << " | pushed " << st.pushed << " processed " << st.processed
+                          << " dropped " << st.dropped << " oversize " << st.oversize
+                          << " conflated " << st.conflated << " decode_errors " << st.decode_errors << std::endl;
+            }
+
+            // 全シャードを合算した段階別レイテンシ（起動からの累計）
+            std::vector<LatencyReportRow> rows = {
+                {"parse", {}}, {"process", {}}, {"predict", {}}, {"execute", {}}, {"total", {}}
+            };
+            for (const auto& lat : shard_latency) {
+                rows[0].snapshot.merge(lat->parse.snapshot());
+                rows[1].snapshot.merge(lat->process.snapshot());
+                rows[2].snapshot.merge(lat->predict.snapshot());
+                rows[3].snapshot.merge(lat->execute.snapshot());
+                rows[4].snapshot.merge(lat->total.snapshot());
+            }
+            rows.push_back({"exit", exit_latency.snapshot()});
+
+            MarketRecorder::Stats rec = recorder.stats();
+            std::cout << "[RECORDER] queue " << rec.queue_depth << " (max " << rec.queue_high_water << ")"
+                      << " | enqueued " << rec.enqueued << " dropped " << rec.dropped
+                      << " written " << rec.written << " flushes " << rec.flushes << std::endl;
+            rows.push_back({"csv_write", rec.write_latency});
+
+            if (config.som_search == SOMSearch::Coherent) {
+                SOMSearchStats search;
+                for (const auto& som : som_models) {
+                    SOMSearchStats s = som.searchStats();
+                    search.predictions += s.predictions;
+                    search.hits += s.hits;
+                }
+                double hit_rate = search.predictions ? 100.0 * search.hits / search.predictions : 0.0;
+                std::cout << "[SOM] coherent search hits " << search.hits << "/" << search.predictions
+                          << " (" << hit_rate << "%)" << std::endl;
+            }
+            if (online_learner) {
+                SOMOnlineLearner::Stats ol = online_learner->stats();
+                std::cout << "[SOM] online rows " << ol.rows << " labels " << ol.labels
+                          << " published " << ol.published << " rebased " << ol.rebased
+                          << " rebuilt " << ol.rebuilt << " adopted " << ol.adopted
+                          << " dropped " << ol.dropped << std::endl;
+            }
+            print_latency_report(rows);
+            append_latency_csv("data/latency_stats.csv", rows);
         }
     }
     
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+学習済み SOM モデルの1ファイル形式（models/SYMBOL_som.bin）の読み書き
+形式は SOMModelFile.h 参照。重み・期待値・リスク・スケーリング・特徴量名・グリッドの幅と高さを
+1つのファイルにまとめ、ヘッダー（checksum のフィールドを除く）とペイロードの CRC-32 をヘッダーに入れる。
+書くときは一時ファイルに書いてから os.replace で置き換えるので、C++ 側が書きかけを読むことはない。
+
+使い方:
+    import som_model
+    som_model.write_model("models/ETHUSDT_som.bin", weights, expectancy, risk, mins, maxs, names, 20, 20, "ETHUSDT")
+    model = som_model.read_model("models/ETHUSDT_som.bin")
+
+従来の4つのCSVからの変換:
+    python som_model.py convert ETHUSDT [models_dir]
+"""
+
+import os
+import struct
+import sys
+import time
+import zlib
+
+import numpy as np
+
+MAGIC = b"MMSOM\0\0\0"
+VERSION = 1
+CHECKSUM_OFFSET = 40
+HEADER_SIZE = 128
+DTYPE_F64 = 1
+NAME_SIZE = 32
+SYMBOL_SIZE = 24
+
+# magic, version, header_size, width, height, feature_count, stride, payload_size, checksum, dtype, created_at, symbol
+_HEADER = struct.Struct("<8sIIIIIIQIIq24s")
+
+
+def checksum(header, payload):
+    """ヘッダー（checksum のフィールドを除く）とペイロードの CRC-32"""
+    crc = zlib.crc32(header[:CHECKSUM_OFFSET])
+    crc = zlib.crc32(header[CHECKSUM_OFFSET + 4:HEADER_SIZE], crc)
+    return zlib.crc32(payload, crc)
+
+
+def model_path(models_dir, symbol):
+    return os.path.join(models_dir, f"{symbol}_som.bin")
+
+
+def padded_stride(feature_count):
+    return (feature_count + 3) // 4 * 4
+
+
+class SOMModel:
+    """読み込んだモデル。weights は (node_count, feature_count)"""
+
+    def __init__(self, weights, expectancy, risk, mins, maxs, names, width, height, symbol="", created_at=0):
+        self.weights = weights
+        self.expectancy = expectancy
+        self.risk = risk
+        self.mins = mins
+        self.maxs = maxs
+        self.names = names
+        self.width = width
+        self.height = height
+        self.symbol = symbol
+        self.created_at = created_at
+
+
+def write_model(path, weights, expectancy, risk, mins, maxs, names, width, height, symbol=""):
+    weights = np.asarray(weights, dtype="<f8")
+    nodes, features = weights.shape
+    if nodes != width * height:
+        raise ValueError(f"grid {width}x{height} does not match {nodes} nodes")
+    if len(expectancy) != nodes or len(risk) != nodes or len(mins) != features or len(maxs) != features:
+        raise ValueError("model arrays have inconsistent lengths")
+    stride = padded_stride(features)
+
+    padded = np.zeros((nodes, stride), dtype="<f8")
+    padded[:, :features] = weights
+    name_bytes = b"".join(str(n).encode()[:NAME_SIZE - 1].ljust(NAME_SIZE, b"\0") for n in names)
+    payload = b"".join([
+        padded.tobytes(),
+        np.asarray(expectancy, dtype="<f8").tobytes(),
+        np.asarray(risk, dtype="<f8").tobytes(),
+        np.asarray(mins, dtype="<f8").tobytes(),
+        np.asarray(maxs, dtype="<f8").tobytes(),
+        name_bytes,
+    ])
+    header = _HEADER.pack(MAGIC, VERSION, HEADER_SIZE, width, height, features, stride,
+                          len(payload), 0, DTYPE_F64, int(time.time()),
+                          symbol.encode()[:SYMBOL_SIZE - 1])
+    header = header.ljust(HEADER_SIZE, b"\0")
+    header = (header[:CHECKSUM_OFFSET] + struct.pack("<I", checksum(header, payload))
+              + header[CHECKSUM_OFFSET + 4:])
+
+    tmp_path = path + ".tmp"
+    with open(tmp_path, "wb") as f:
+        f.write(header)
+        f.write(payload)
+    os.replace(tmp_path, path)
+
+
+def read_model(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER_SIZE:
+        raise ValueError(f"truncated SOM model: {path}")
+    (magic, version, header_size, width, height, features, stride,
+     size, stored_checksum, dtype, created_at, symbol) = _HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or header_size != HEADER_SIZE or dtype != DTYPE_F64:
+        raise ValueError(f"unsupported SOM model: {path}")
+    nodes = width * height
+    payload = data[HEADER_SIZE:HEADER_SIZE + size]
+    if len(payload) != size or checksum(data[:HEADER_SIZE], payload) != stored_checksum:
+        raise ValueError(f"SOM model checksum mismatch: {path}")
+
+    offset = 0
+
+    def take(count):
+        nonlocal offset
+        values = np.frombuffer(payload, dtype="<f8", count=count, offset=offset)
+        offset += count * 8
+        return values.copy()
+
+    weights = take(nodes * stride).reshape(nodes, stride)[:, :features]
+    expectancy = take(nodes)
+    risk = take(nodes)
+    mins = take(features)
+    maxs = take(features)
+    names = [payload[offset + i * NAME_SIZE:offset + (i + 1) * NAME_SIZE].split(b"\0", 1)[0].decode()
+             for i in range(features)]
+    return SOMModel(np.ascontiguousarray(weights), expectancy, risk, mins, maxs, names, width, height,
+                    symbol.split(b"\0", 1)[0].decode(), created_at)
+
+
+def convert_csv(symbol, models_dir="models"):
+    """models_dir/SYMBOL_{map_weights,expectancy,risk_map,scaling_params}.csv → models_dir/SYMBOL_som.bin"""
+    prefix = os.path.join(models_dir, f"{symbol}_")
+    weights = np.loadtxt(f"{prefix}map_weights.csv", delimiter=",", ndmin=2)
+    expectancy = np.loadtxt(f"{prefix}expectancy.csv", delimiter=",", ndmin=1)
+    risk_path = f"{prefix}risk_map.csv"
+    if os.path.exists(risk_path):
+        risk = np.loadtxt(risk_path, delimiter=",", ndmin=1)
+    else:
+        risk = np.full(len(weights), 0.05)
+
+    names, mins, maxs = [], [], []
+    with open(f"{prefix}scaling_params.csv") as f:
+        next(f)  # ヘッダー
+        for line in f:
+            cols = line.strip().split(",")
+            if len(cols) >= 3:
+                names.append(cols[0])
+                mins.append(float(cols[1]))
+                maxs.append(float(cols[2]))
+
+    # CSVには幅・高さが無いので正方形とみなす
+    nodes = len(weights)
+    side = int(round(nodes ** 0.5))
+    width, height = (side, side) if side * side == nodes else (nodes, 1)
+    path = model_path(models_dir, symbol)
+    write_model(path, weights, expectancy, risk, mins, maxs, names, width, height, symbol)
+    return path
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3 or sys.argv[1] != "convert":
+        print("使用法: python som_model.py convert <symbol> [models_dir]")
+        sys.exit(1)
+    out = convert_csv(sys.argv[2], sys.argv[3] if len(sys.argv) > 3 else "models")
+    print(f"✅ {out} を書き出しました")
@@ -5,8 +5,9 @@ C++から出力される市場データを使用してSOMモデルを訓練す
 
 新しいCSV形式: timestamp,symbol,imbalance,imbalance_change
 
-使い方: python train_som.py <symbol>
+使い方: python train_som.py <symbol> [width height]
 例: python train_som.py ETHUSDT
+    python train_som.py ETHUSDT 40 40
 """
 
 import pandas as pd
@@ -16,19 +17,37 @@ import os
 from sklearn.preprocessing import MinMaxScaler
 import random
 
+try:
+    import feature_store
+except ImportError:
+    feature_store = None
+
+try:
+    import som_model
+except ImportError:
+    som_model = None
+
 # ==================== 設定 ====================
 MIN_REQUIRED_DATA = 500  # 学習に必要な最小データ数
-SOM_WIDTH = 20           # SOMグリッドの幅
+SOM_WIDTH = 20           # SOMグリッドの幅（引数で変更可。C++ はモデルファイルから読む）
 SOM_HEIGHT = 20          # SOMグリッドの高さ
 EPOCHS = 20              # 学習エポック数
+TRAIN_ROWS = 30000       # 学習に使う最新の行数
+FUTURE_ROWS = 30         # 何行先の価格で損益を見るか
 
 # ==================== 1. コマンドライン引数の取得 ====================
 if len(sys.argv) < 2:
-    print("使用法: python train_som.py <symbol>")
+    print("使用法: python train_som.py <symbol> [width height]")
     print("例: python train_som.py ETHUSDT")
     sys.exit(1)
 
 target_symbol = sys.argv[1]
+if len(sys.argv) >= 4:
+    SOM_WIDTH = int(sys.argv[2])
+    SOM_HEIGHT = int(sys.argv[3])
+    if SOM_WIDTH < 1 or SOM_HEIGHT < 1:
+        print("Error: width and height must be positive")
+        sys.exit(1)
 support_symbol = 'BTCUSDT'
 
 # ==================== 2. ファイル名の準備 ====================
@@ -38,25 +57,43 @@ models_dir = "models"
 target_market_path = f"{data_dir}/{target_symbol}_market_data.csv"
 support_market_path = f"{data_dir}/{support_symbol}_market_data.csv"
 
+# 列形式の特徴量ファイルがあればそちらを memmap で読む（CSVの全行解析を避ける）
+# 時間で区切られたパーティションのうち、必要な分だけを開く
+# （足りない分は区切る前の履歴から読む。特徴量ファイルを書く前の CSV の行も含む。feature_store.read_legacy_tail）
+use_feature_store = (feature_store is not None
+                     and feature_store.has_features(data_dir, target_symbol)
+                     and feature_store.has_features(data_dir, support_symbol))
+
 # ==================== 3. ファイル存在確認 ====================
 if not os.path.exists(data_dir):
     print(f"Error: {data_dir} directory not found")
     sys.exit(1)
 
-if not os.path.exists(target_market_path):
+if not use_feature_store and not os.path.exists(target_market_path):
     print(f"Error: Market data file not found: {target_market_path}")
     sys.exit(1)
 
-if not os.path.exists(support_market_path):
+if not use_feature_store and not os.path.exists(support_market_path):
     print(f"Error: Support market file not found: {support_market_path}")
     sys.exit(1)
 
 # ==================== 4. データの読み込み ====================
-# total_depth, price, btc_price, volatility, btc_corr が追加されている
-cols = ['timestamp', 'symbol', 'imbalance', 'imbalance_change', 'total_depth', 'price', 'btc_price', 'volatility', 'btc_corr']
-
-df_target = pd.read_csv(target_market_path, names=cols, header=0)
-df_support = pd.read_csv(support_market_path, names=cols, header=0)
+# total_depth, price, btc_price, volatility, btc_pearson が追加されている
+# btc_pearson は以前の btc_corr（騰落率の比）を置き換えた列。古いCSVは起動時に退避されるので混ざらない
+cols = ['timestamp', 'symbol', 'imbalance', 'imbalance_change', 'total_depth', 'price', 'btc_price', 'volatility', 'btc_pearson']
+
+if use_feature_store:
+    # 学習に使う末尾の行（未来の価格を見る分と少しの余裕を足す）と、その時間帯のBTCだけを読む
+    df_target = feature_store.read_symbol_tail(data_dir, target_symbol, TRAIN_ROWS + FUTURE_ROWS + 60)
+    if len(df_target) == 0:
+        print(f"Error: no feature data for {target_symbol}")
+        sys.exit(1)
+    df_support = feature_store.read_symbol_range(data_dir, support_symbol,
+                                                 df_target['timestamp'].iloc[0] - 60,
+                                                 df_target['timestamp'].iloc[-1])
+else:
+    df_target = pd.read_csv(target_market_path, names=cols, header=0)
+    df_support = pd.read_csv(support_market_path, names=cols, header=0)
 
 # タイムスタンプを数値に変換してソート
 df_target['timestamp'] = pd.to_numeric(df_target['timestamp'], errors='coerce')
@@ -81,7 +118,7 @@ combined_df = combined_df.dropna(subset=['btc_imbalance'])
 
 # 1. 未来のデータを「今」の行に持ってくる (30行 = 約30秒先と仮定)
 # imbalance_change を 30個分上にずらす
-combined_df['future_pnl'] = (combined_df['price'].shift(-30) - combined_df['price']) / combined_df['price']
+combined_df['future_pnl'] = (combined_df['price'].shift(-FUTURE_ROWS) - combined_df['price']) / combined_df['price']
 # 2. 特徴量の準備セクションで、price_changes を future_pnl に変える
 # feature_data を作る前に shift するので、dropna が必要
 combined_df = combined_df.dropna(subset=['btc_imbalance', 'future_pnl'])
@@ -100,11 +137,11 @@ features = [
     'btc_imbalance_change',
     'total_depth',    # 追加：板の厚み
     'volatility',     # 追加：相場の荒れ具合
-    'btc_corr'        # 追加：BTCとの連動性
+    'btc_pearson'     # 追加：BTCとの連動性（1秒収益率のピアソン相関）
 ]
 
 # 最新のデータを使用
-working_df = combined_df.tail(30000).copy()
+working_df = combined_df.tail(TRAIN_ROWS).copy()
 
 # データテーブルの構築（最新30000行を使用）
 feature_data = working_df[features].reset_index(drop=True)
@@ -209,6 +246,13 @@ scaling_params = pd.DataFrame({
 })
 scaling_params.to_csv(f"{prefix}scaling_params.csv", index=False)
 
+# 1ファイル形式（C++ はこちらを優先して読む。一時ファイルから置き換えるので書きかけは見えない）
+if som_model is not None:
+    som_model.write_model(som_model.model_path(models_dir, target_symbol),
+                          som_weights, expectancy_map, risk_map,
+                          scaler.data_min_, scaler.data_max_, features,
+                          width, height, target_symbol)
+
 # ==================== 13. 完了メッセージ ====================
 print(f"\n✅ {target_symbol} の訓練が完了しました")
 print(f"  - 処理した市場データ: {len(feature_data)} 行")
@@ -218,4 +262,6 @@ print(f"  - 保存されたファイル:")
 print(f"    - {prefix}map_weights.csv (SOM重み)")
 print(f"    - {prefix}expectancy.csv (期待値マップ)")
 print(f"    - {prefix}risk_map.csv (リスクマップ)")
-print(f"    - {prefix}scaling_params.csv (正規化パラメータ)")
\ No newline at end of file
+print(f"    - {prefix}scaling_params.csv (正規化パラメータ)")
+if som_model is not None:
+    print(f"    - {som_model.model_path(models_dir, target_symbol)} (1ファイル形式のモデル)")
\ No newline at end of file